@@ -0,0 +1,120 @@
+/* //////////////////////////////////////////////////////////////////
+// File: libxsim.h
+// Description: C interface to the simulator for programs that run it
+//              in-process (lib/libxsim.a or lib/libxsim.so, linked
+//              with -ljsoncpp -lrt -ldl -lpthread). Programs, settings
+//              and results are passed in memory; nothing is read from
+//              or written to files.
+//
+//              The simulator state lives in thread-local storage, so a
+//              thread can have one instance at a time and every call on
+//              an instance must come from the thread that created it.
+//              Threads run independently. libxsim.so can be dlopen()ed
+//              or loaded through an FFI; libxsim.a reaches the state
+//              faster and suits programs that link it in.
+//
+//              xsim * x = xsim_create();
+//              xsim_load(x, text, strlen(text));
+//              while (...) {
+//                  xsim_reset(x);
+//                  if (xsim_run(x) == XSIM_HALTED) {
+//                      xsim_stats(x, &stats);
+//                  }
+//              }
+//              xsim_destroy(x);
+// Author: ZDHull
+// Date: 2026/10/19
+// ////////////////////////////////////////////////////////////////// */
+
+#ifndef _libXsim_
+#define _libXsim_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The only symbols libxsim.so exports */
+#pragma GCC visibility push(default)
+
+/* Why xsim_run or xsim_step returned */
+#define XSIM_HALTED 0			/* Executed HALT */
+#define XSIM_FAULT 1			/* Stopped on an error, PC is 0xFFFF */
+#define XSIM_STEPPED 2			/* Executed the instructions asked for */
+#define XSIM_INSTRUCTION_LIMIT 3	/* Reached max_instructions */
+#define XSIM_TIME_LIMIT 4		/* Reached max_seconds */
+#define XSIM_ERROR -1			/* Bad argument, or called from another thread */
+
+#define XSIM_ENGINE_REFERENCE 0
+#define XSIM_ENGINE_FAST 1
+
+#define XSIM_STATS 22
+
+typedef struct xsim xsim;
+
+/* Settings, as in the configuration file and command line options */
+struct xsim_config {
+    int latency[8];			/* add, sub, and, nor, div, mul, mod, exp */
+    int engine;				/* XSIM_ENGINE_* */
+    long memoize_kb;			/* Fast engine memo table, 0 for none */
+    long long max_instructions;		/* Instruction limit per run, 0 for none */
+    double max_seconds;			/* Wall time limit per run, 0 for none */
+    unsigned int mem_size;		/* Bytes of data memory in each bank */
+    unsigned int mem_banks;		/* Banks LW/SW can select */
+    int perf_isa;			/* Non-zero for RDCYC, RDINST, RDEVT and MARK */
+};
+
+struct xsim_registers {
+    short int r[8];
+    unsigned short int pc;
+};
+
+/* Counters of the "stats" object of the output file */
+struct xsim_stats {
+    unsigned long long count[XSIM_STATS];	/* Per instruction, see xsim_stat_name */
+    unsigned long long instructions;
+    unsigned long long cycles;
+};
+
+/* Instance for the calling thread, 0 if it already has one */
+xsim * xsim_create(void);
+void xsim_destroy(xsim * x);
+
+/* Latencies 1, reference engine, no limits, one 64 KB bank, base ISA */
+void xsim_default_config(struct xsim_config * config);
+/* Applies the settings and restarts the loaded program */
+int xsim_configure(xsim * x, const struct xsim_config * config);
+
+/* Program as the text of a program file */
+int xsim_load(xsim * x, const char * text, size_t length);
+/* Program as instruction memory bytes, big-endian words */
+int xsim_load_binary(xsim * x, const unsigned char * code, size_t length);
+/* Restarts the loaded program with clear registers, memory and counters */
+int xsim_reset(xsim * x);
+
+/* Runs until HALT, an error or a configured limit */
+int xsim_run(xsim * x);
+/* Runs at most count instructions with the reference engine */
+int xsim_step(xsim * x, unsigned long long count);
+
+int xsim_registers(xsim * x, struct xsim_registers * regs);
+int xsim_stats(xsim * x, struct xsim_stats * stats);
+/* Copies length bytes of data memory starting at addr of bank */
+int xsim_read_data(xsim * x, unsigned int bank, unsigned int addr, unsigned char * buffer, size_t length);
+/* Stores length bytes, after xsim_reset to set the initial data memory */
+int xsim_write_data(xsim * x, unsigned int bank, unsigned int addr, const unsigned char * buffer, size_t length);
+/* Hash of all of data memory, equal for equal contents */
+unsigned long long xsim_data_digest(xsim * x);
+/* What the program printed since it was loaded or reset */
+const char * xsim_output(xsim * x);
+/* Output name of count[index] */
+const char * xsim_stat_name(int index);
+
+#pragma GCC visibility pop
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,19 @@
+// //////////////////////////////////////////////////////////////////
+// File: xanalyze.h
+// Description: Static control-flow analysis of the loaded program
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xAnalyze_
+#define _xAnalyze_
+
+#include "xlibrary.h"
+
+// Non-zero when --analyze was given
+extern int analyze_enabled;
+
+// Public Functions
+void analyze_write(char * filename);
+
+#endif
@@ -0,0 +1,83 @@
+// //////////////////////////////////////////////////////////////////
+// File: xblock.h
+// Description: Predecoded basic blocks of instruction memory, used by
+//              the fast engine
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xBlock_
+#define _xBlock_
+
+#include "xlibrary.h"
+#include <vector>
+
+// Longest block decoded, longer straight-line code is split
+#define MAX_BLOCK_LENGTH 64
+
+// Block properties
+#define BLOCK_CAN_FAULT 1	// Holds DIV, MOD, LW or SW
+#define BLOCK_HAS_MEM 2		// Holds LW or SW
+#define BLOCK_HAS_IO 4		// Holds PUT or an invalid opcode
+#define BLOCK_PURE 8		// Only reads and writes registers, no HALT
+
+// Kinds of self loop, a block ending in a conditional branch to itself
+enum Loop_Kind {LOOP_NONE, LOOP_ITERATE, LOOP_INDUCTION, LOOP_BULK};
+
+// One predecoded instruction
+struct xop {
+    unsigned char opcode;	// 5-bit opcode
+    unsigned char rd, rs, rt;	// Register fields
+    short int imm;		// Value loaded by LIZ/LIS, IMM8 of LUI
+    unsigned short int target;	// Taken address of branches and J
+};
+
+// One predecoded block, entered only at its first instruction
+struct xblock {
+    unsigned short int start;	// Address of the first instruction
+    unsigned short int next;	// Address after the last instruction
+    unsigned int length;	// Instructions, including the terminator
+    unsigned int first;		// Index of the first op in block_ops
+    unsigned int mix_first;	// Index of the first entry in block_mix
+    unsigned int mix_length;	// Entries in block_mix
+    int flags;			// BLOCK_* properties
+    int loop;			// Loop_Kind
+    int live_in;		// Registers read before the block writes them
+    int live_out;		// Registers the block writes
+    int memo;			// Non-zero while memoizing the block pays off
+    unsigned int memo_tries;	// Memo lookups while on trial
+    unsigned int memo_hits;	// Memo hits while on trial
+    unsigned long long runs;	// Completed runs not yet in clock_cycles
+};
+
+// Instructions of one Instruction_Name in a block
+struct xmix {
+    unsigned int name;		// Instruction_Name
+    unsigned int count;		// Times it appears
+};
+
+extern thread_local std::vector<struct xblock> blocks;
+extern thread_local std::vector<struct xop> block_ops;
+extern thread_local std::vector<struct xmix> block_mix;
+extern __thread int block_index[MEM_SIZE/2];
+
+// Public Functions
+void block_reset();
+void block_op(unsigned short int addr, struct xop * op);
+int block_ends(unsigned short int opcode);
+int block_loop_kind(const struct xop * ops, unsigned int length, unsigned short int start);
+unsigned long long block_trips(const struct xop * op, unsigned int length, const short int * regs, unsigned short int * step);
+int block_decode(unsigned short int pc);
+void block_flush();
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Even address of the block's first instruction
+// Outputs: Index into blocks, decoding the block on first use
+// /////////////////////////////////////////////////////////////////
+static inline int block_find(unsigned short int pc) {
+    int index = block_index[pc >> 1];
+
+    return (index >= 0) ? index : block_decode(pc);
+}
+
+#endif
@@ -0,0 +1,39 @@
+// //////////////////////////////////////////////////////////////////
+// File: xcore.h
+// Description: Simulator state and the steps of a run. Every thread
+//              has its own copy of the state, so each thread can run
+//              one program at a time.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xCore_
+#define _xCore_
+
+#include "xlibrary.h"
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread int latency_vals[8];
+extern __thread int program_size;
+extern __thread int trace_enabled;
+extern __thread long long max_instructions;
+extern __thread double max_seconds;
+extern __thread int limit_hit;
+// //////////////////////////////////////////
+
+// Public Functions
+int load_program(std::istream & in);
+void read_config(char * filename);
+void apply_config(const Json::Value & root);
+void reset_state();
+void periodic_start();
+void dump_state(const char * reason);
+void write_output(char * filename);
+void build_output(Json::Value & array);
+int format_output(char * buffer, int size);
+void count_totals(unsigned long long * inst_count, unsigned long long * num_cycles);
+void read_data_mem();
+void write_data_mem();
+
+#endif
@@ -0,0 +1,21 @@
+// //////////////////////////////////////////////////////////////////
+// File: xcritpath.h
+// Description: Dataflow critical-path (ILP limit) analysis
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xCritPath_
+#define _xCritPath_
+
+#include "xlibrary.h"
+
+// Set when the analysis is requested on the command line
+extern __thread int critpath_enabled;
+
+// Public Functions
+void critpath_reset();
+void critpath_update(unsigned short int inst, unsigned short int mem_addr);
+void critpath_write(Json::Value & array, unsigned long long serial_cycles);
+
+#endif
@@ -0,0 +1,357 @@
+// //////////////////////////////////////////////////////////////////
+// File: xengine.h
+// Description: The execution loop, instantiated once per
+//              instrumentation tool. A tool is any class with the six
+//              members below plus one constant per callback saying
+//              whether it is wanted; callbacks that are not wanted are
+//              removed at compile time. The trace, critical path,
+//              profile and self profile live in analysis_tool, so
+//              run_engine<null_tool> does no instrumentation in its
+//              loop; only the x_* handlers, shared with the fast
+//              engine, still test the trace flag and the watchpoints.
+//
+//              struct my_tool {
+//                  static const bool wants_instruction = true;
+//                  static const bool wants_retire = false;
+//                  static const bool wants_mem = false;
+//                  static const bool wants_branch = false;
+//                  static const bool wants_halt = true;
+//                  void on_instruction(unsigned short int pc, unsigned short int inst);
+//                  void on_retire(unsigned short int pc, unsigned short int inst, unsigned short int next_pc);
+//                  void on_mem_read(unsigned short int pc, unsigned short int addr, short int value);
+//                  void on_mem_write(unsigned short int pc, unsigned short int addr, short int old_value, short int new_value);
+//                  void on_branch(unsigned short int pc, unsigned short int target, bool taken);
+//                  void on_halt();
+//              };
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xEngine_
+#define _xEngine_
+
+#include "xlibrary.h"
+#include "xplugin.h"
+#include "xcritpath.h"
+#include "xprofile.h"
+#include "xselfprof.h"
+#include "xmem.h"
+#include "xperf.h"
+#include "xsample.h"
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread unsigned char inst_memory[MEM_SIZE];
+extern __thread short int reg_file[8];
+extern __thread unsigned short int program_counter;
+extern __thread unsigned long long clock_cycles[22];
+// //////////////////////////////////////////
+
+// Periodic work scheduled by the caller (xcore.cpp), a non-zero return
+// of periodic_events stops execution
+long long periodic_next();
+int periodic_events(long long span);
+
+// A tool with no callbacks
+struct null_tool {
+    static const bool wants_instruction = false;
+    static const bool wants_retire = false;
+    static const bool wants_mem = false;
+    static const bool wants_branch = false;
+    static const bool wants_halt = false;
+    void on_instruction(unsigned short int pc, unsigned short int inst) {}
+    void on_retire(unsigned short int pc, unsigned short int inst, unsigned short int next_pc) {}
+    void on_mem_read(unsigned short int pc, unsigned short int addr, short int value) {}
+    void on_mem_write(unsigned short int pc, unsigned short int addr, short int old_value, short int new_value) {}
+    void on_branch(unsigned short int pc, unsigned short int target, bool taken) {}
+    void on_halt() {}
+};
+
+// The trace, critical path, profile and self profile, each behind its
+// own flag
+struct analysis_tool {
+    static const bool wants_instruction = true;
+    static const bool wants_retire = true;
+    static const bool wants_mem = false;
+    static const bool wants_branch = false;
+    static const bool wants_halt = false;
+    unsigned short int cp_addr;		// LW/SW address for the critical path
+    void on_instruction(unsigned short int pc, unsigned short int inst) {
+	unsigned short int opcode;		// Opcode Value
+
+	get_opcode(inst, &opcode);
+
+	// The address register may be the destination of a LW
+	if (critpath_enabled) {
+	    cp_addr = (unsigned short int)reg_file[(inst >> 5) & 0x0007];
+	}
+
+	trace_fetch(inst);
+
+	// Charge the handler for this opcode
+	if (selfprof_enabled) {
+	    selfprof_switch((get_inst_name(opcode) >= 0) ? get_inst_name(opcode) : SP_INVALID);
+	}
+    }
+    void on_retire(unsigned short int pc, unsigned short int inst, unsigned short int next_pc) {
+	// Back to dispatch
+	if (selfprof_enabled) {
+	    selfprof_switch(SP_DISPATCH);
+	}
+
+	// Track dataflow ready times of instructions that completed
+	if (critpath_enabled && (next_pc != (unsigned short int)-1)) {
+	    critpath_update(inst, cp_addr);
+	}
+
+	// Count the instruction against its address and call path
+	if (profile_enabled) {
+	    profile_update(pc, inst, next_pc);
+	}
+    }
+    void on_mem_read(unsigned short int pc, unsigned short int addr, short int value) {}
+    void on_mem_write(unsigned short int pc, unsigned short int addr, short int old_value, short int new_value) {}
+    void on_branch(unsigned short int pc, unsigned short int target, bool taken) {}
+    void on_halt() {}
+};
+
+// Forwards to a plugin loaded at run time, one branch per callback the
+// plugin left empty
+struct plugin_tool : analysis_tool {
+    static const bool wants_mem = true;
+    static const bool wants_branch = true;
+    static const bool wants_halt = true;
+    struct xsim_plugin * plugin;
+    void on_instruction(unsigned short int pc, unsigned short int inst) {
+	analysis_tool::on_instruction(pc, inst);
+	if (sample_enabled) {
+	    sample_fetch(pc);
+	}
+	if (plugin->on_instruction) {
+	    plugin->on_instruction(plugin->data, pc, inst);
+	}
+    }
+    void on_mem_read(unsigned short int pc, unsigned short int addr, short int value) {
+	if (plugin->on_mem_read) {
+	    plugin->on_mem_read(plugin->data, pc, addr, value);
+	}
+    }
+    void on_mem_write(unsigned short int pc, unsigned short int addr, short int old_value, short int new_value) {
+	if (plugin->on_mem_write) {
+	    plugin->on_mem_write(plugin->data, pc, addr, old_value, new_value);
+	}
+    }
+    void on_branch(unsigned short int pc, unsigned short int target, bool taken) {
+	if (sample_enabled) {
+	    sample_jump(inst_memory[pc] >> 3);
+	}
+	if (plugin->on_branch) {
+	    plugin->on_branch(plugin->data, pc, target, taken);
+	}
+    }
+    void on_halt() {
+	if (plugin->on_halt) {
+	    plugin->on_halt(plugin->data, reg_file, clock_cycles);
+	}
+    }
+};
+
+// Publishes the PC and call depth the --sample timer reads
+struct sample_tool : analysis_tool {
+    static const bool wants_branch = true;
+    void on_instruction(unsigned short int pc, unsigned short int inst) {
+	analysis_tool::on_instruction(pc, inst);
+	sample_fetch(pc);
+    }
+    void on_branch(unsigned short int pc, unsigned short int target, bool taken) {
+	sample_jump(inst_memory[pc] >> 3);
+    }
+};
+
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: One instruction, its opcode and the halting flag
+// Description: Executes the instruction with its x_* handler and sets
+//              program_counter (or the halting flag)
+// /////////////////////////////////////////////////////////////////
+static inline void engine_dispatch(short int instruction, unsigned short int opcode, short int * halt_all) {
+
+    switch (opcode){
+	case (0x00):
+	    program_counter = x_add(instruction);
+	    break;
+	case (0x01):
+	    program_counter = x_sub(instruction);
+	    break;
+	case (0x02):
+	    program_counter = x_and(instruction);
+	    break;
+	case (0x03):
+	    program_counter = x_nor(instruction);
+	    break;
+	case (0x04):
+	    program_counter = x_div(instruction);
+	    break;
+	case (0x05):
+	    program_counter = x_mul(instruction);
+	    break;
+	case (0x06):
+	    program_counter = x_mod(instruction);
+	    break;
+	case (0x07):
+	    program_counter = x_exp(instruction);
+	    break;
+	case (0x08):
+	    program_counter = x_lw(instruction);
+	    break;
+	case (0x09):
+	    program_counter = x_sw(instruction);
+	    break;
+	case (0x10):
+	    program_counter = x_liz(instruction);
+	    break;
+	case (0x11):
+	    program_counter = x_lis(instruction);
+	    break;
+	case (0x12):
+	    program_counter = x_lui(instruction);
+	    break;
+	case (0x14):
+	    program_counter = x_bp(instruction);
+	    break;
+	case (0x15):
+	    program_counter = x_bn(instruction);
+	    break;
+	case (0x16):
+	    program_counter = x_bx(instruction);
+	    break;
+	case (0x17):
+	    program_counter = x_bz(instruction);
+	    break;
+	case (0x0C):
+	    program_counter = x_jr(instruction);
+	    break;
+	case (0x13):
+	    program_counter = x_jalr(instruction);
+	    break;
+	case (0x18):
+	    program_counter = x_j(instruction);
+	    break;
+	case (0x0D):
+	    *halt_all = x_halt(instruction);
+	    break;
+	case (0x0E):
+	    program_counter = x_put(instruction);
+	    break;
+	default:
+	    if (perf_opcode(opcode)) {
+		program_counter = perf_execute(instruction, opcode);
+		break;
+	    }
+	    *guest_out << "Invalid Opcode: " << opcode << std::endl;
+	    program_counter += 2;
+	    break;
+    }
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Tool receiving the callbacks
+// Outputs: Halting flag, 0 when execution stopped on an error
+// Description: Executes from program_counter until HALT or an error
+// /////////////////////////////////////////////////////////////////
+template <class Tool>
+short int run_engine(Tool & tool) {
+    short int halt_all;				// Halting Flag
+    short int instruction;			// 16-Bit value of instruction
+    unsigned short int opcode;			// Opcode Value
+    unsigned short int last_pc;			// Address of current instruction
+    unsigned short int mem_addr;		// Address used by LW/SW
+    unsigned int mem_bank_used;			// Bank used by LW/SW
+    short int mem_old;				// Word overwritten by SW
+    long long periodic_countdown;		// Instructions until periodic work
+    long long periodic_span;			// Instructions between periodic work
+
+    halt_all = 0;
+    mem_addr = 0;
+    mem_bank_used = 0;
+    mem_old = 0;
+
+    periodic_span = periodic_next();
+    periodic_countdown = periodic_span;
+
+    // Loop until halt flag is set or error occurs
+    while ((!halt_all) && (program_counter != (unsigned short int)-1)) {
+
+#ifdef DEBUG
+	    std::cout << "PC: " << program_counter << std::endl;
+#endif
+
+	    // Get instruction from instruction memory
+	    instruction = (unsigned short int)(inst_memory[program_counter] << 8) | (unsigned short int)(inst_memory[program_counter + 1]);
+	    last_pc = program_counter;
+
+	    // Get the opcode of instruction
+	    get_opcode(instruction, &opcode);
+
+	    if constexpr (Tool::wants_instruction) {
+		tool.on_instruction(last_pc, instruction);
+	    }
+
+	    // Remember the address and old word of memory accesses
+	    if constexpr (Tool::wants_mem) {
+		if ((opcode == 0x08) || (opcode == 0x09)) {
+		    mem_addr = (unsigned short int)reg_file[(instruction >> 5) & 0x0007];
+		    mem_bank_used = mem_bank(opcode, (instruction >> 8) & 0x0007, (instruction >> 2) & 0x0007);
+		    mem_old = mem_load(mem_bank_used, mem_addr & 0xFFFE);
+		}
+	    }
+
+	    // Perform appropriate operation based on opcode		
+	    engine_dispatch(instruction, opcode, &halt_all);
+
+	    if constexpr (Tool::wants_retire) {
+		tool.on_retire(last_pc, instruction, program_counter);
+	    }
+
+	    // Report completed memory accesses
+	    if constexpr (Tool::wants_mem) {
+		if (program_counter != (unsigned short int)-1) {
+		    if (opcode == 0x08) {
+			tool.on_mem_read(last_pc, mem_addr, reg_file[(instruction >> 8) & 0x0007]);
+		    }
+		    else if (opcode == 0x09) {
+			tool.on_mem_write(last_pc, mem_addr, mem_old, mem_load(mem_bank_used, mem_addr));
+		    }
+		}
+	    }
+
+	    // Report branches and jumps
+	    if constexpr (Tool::wants_branch) {
+		if ((program_counter != (unsigned short int)-1) && (((opcode >= 0x13) && (opcode <= 0x18)) || (opcode == 0x0C))) {
+		    tool.on_branch(last_pc, program_counter, program_counter != (unsigned short int)(last_pc + 2));
+		}
+	    }
+
+	    // Periodic work such as publishing live metrics or run limits
+	    if (--periodic_countdown == 0) {
+		if (periodic_events(periodic_span)) {
+		    break;
+		}
+		periodic_span = periodic_next();
+		periodic_countdown = periodic_span;
+	    }
+
+#ifdef DEBUG
+	    std::cout << std::endl;
+#endif
+    }
+
+    if constexpr (Tool::wants_halt) {
+	tool.on_halt();
+    }
+
+    return halt_all;
+}
+
+#endif
@@ -0,0 +1,19 @@
+// //////////////////////////////////////////////////////////////////
+// File: xfast.h
+// Description: Block-at-a-time execution engine
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xFast_
+#define _xFast_
+
+#include "xlibrary.h"
+
+// Non-zero when --engine=fast was given
+extern __thread int fast_enabled;
+
+// Public Functions
+short int run_fast();
+
+#endif
@@ -0,0 +1,21 @@
+// //////////////////////////////////////////////////////////////////
+// File: xinterval.h
+// Description: Per-interval statistics streamed as JSON Lines
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xInterval_
+#define _xInterval_
+
+#include "xlibrary.h"
+
+// Instructions per interval, 0 when streaming is off
+extern long long interval_length;
+
+// Public Functions
+int interval_open(const char * filename);
+void interval_emit();
+void interval_close();
+
+#endif
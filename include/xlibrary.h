@@ -24,12 +24,28 @@
 // Uncomment for more output to terminal
 //#define DEBUG
 
+// Exit codes when a run limit stops the program
+#define EXIT_INSTRUCTION_LIMIT 2
+#define EXIT_TIME_LIMIT 3
+
 // Create enumerated types for instructions
 enum Latency {ADD, SUB, AND, NOR, DIV, MUL, MOD, EXP};
+enum Run_Limit {LIMIT_NONE, LIMIT_INSTRUCTIONS, LIMIT_SECONDS};
 enum Instruction_Name {N_ADD, N_SUB, N_AND, N_NOR, N_DIV, N_MUL, N_MOD, N_EXP, N_LW, N_SW, N_LIZ, N_LIS, N_LUI, N_BP, N_BN, N_BX, N_BZ, N_JR, N_JAL, N_J, N_HALT, N_PUT};
 
+// Output names of the stat counters, in Instruction_Name order
+extern const char * stat_names[22];
+
+// Where the calling thread prints guest output: PUT, the trace and the
+// messages of instructions that stop execution. cout unless redirected.
+extern __thread std::ostream * guest_out;
+
 // Public Functions
 void get_opcode(unsigned short int inst, unsigned short int * op);
+int get_inst_name(unsigned short int op);
+short int exp_value(short int base, short int power);
+void trace_fetch(short int inst);
+void trace_inst(const char * name);
 
 short int x_add(short int inst);
 short int x_sub(short int inst);
@@ -0,0 +1,72 @@
+// //////////////////////////////////////////////////////////////////
+// File: xlive.h
+// Description: Live metrics published by running simulations in POSIX
+//              shared memory, and read by xsim-top
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xLive_
+#define _xLive_
+
+#include <errno.h>
+#include <signal.h>
+
+// Segments are named LIVE_SHM_PREFIX<pid> and appear in LIVE_SHM_DIR
+#define LIVE_SHM_PREFIX "/xsim."
+#define LIVE_SHM_DIR "/dev/shm"
+#define LIVE_MAGIC 0x5853494D
+#define LIVE_VERSION 1
+
+// Instructions between two updates of the segment
+#define LIVE_PERIOD 65536
+
+// Seconds a finished segment is kept so readers see its final state
+#define LIVE_LINGER_SECONDS 10
+
+// Values of live_metrics.state
+enum Live_State {LIVE_RUNNING = 1, LIVE_HALTED, LIVE_ERROR, LIVE_LIMIT};
+
+// Layout of one segment. Written under a sequence lock: the writer makes
+// sequence odd, updates the fields, and makes it even again. Readers
+// retry while sequence is odd or changed during their copy, so the
+// writer never waits for them.
+struct live_metrics {
+    unsigned int magic;			// LIVE_MAGIC
+    unsigned int version;		// LIVE_VERSION
+    int pid;				// Simulating process
+    unsigned int sequence;		// Sequence lock
+    unsigned int state;			// Live_State
+    unsigned short int program_counter;	// Current guest PC
+    char program[128];			// Input file name
+    unsigned long long start_ns;	// CLOCK_REALTIME at start
+    unsigned long long update_ns;	// CLOCK_REALTIME at last update
+    unsigned long long instructions;	// Guest instructions executed
+    unsigned long long clock_cycles[22];	// Per opcode counts
+    double mips;			// Guest MIPS since the last update
+    double average_mips;		// Guest MIPS since the start
+};
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Copy of a segment, CLOCK_REALTIME now
+// Outputs: Non-zero when anyone may remove the segment: it finished
+//          LIVE_LINGER_SECONDS ago, or its process died while running
+// /////////////////////////////////////////////////////////////////
+static inline int live_expired(const struct live_metrics * copy, unsigned long long now_ns) {
+
+    if (copy->state == LIVE_RUNNING) {
+	return (kill(copy->pid, 0) != 0) && (errno == ESRCH);
+    }
+
+    return (now_ns > copy->update_ns) && ((now_ns - copy->update_ns) / 1000000000ULL >= LIVE_LINGER_SECONDS);
+}
+
+// Set when live metrics are requested on the command line
+extern int live_enabled;
+
+// Public Functions
+int live_open(const char * program);
+void live_publish(int state);
+void live_close(int state);
+
+#endif
@@ -0,0 +1,100 @@
+// //////////////////////////////////////////////////////////////////
+// File: xmem.h
+// Description: Data memory made of pages allocated on first store
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xMem_
+#define _xMem_
+
+#include "xlibrary.h"
+
+// Bytes per page of data memory
+#define MEM_PAGE_BITS 8
+#define MEM_PAGE_SIZE (1 << MEM_PAGE_BITS)
+#define MEM_BANK_PAGES (MEM_SIZE / MEM_PAGE_SIZE)
+// Banks the 3-bit bank field of LW/SW can select
+#define MEM_MAX_BANKS 8
+
+extern __thread const unsigned char * mem_pages[MEM_MAX_BANKS * MEM_BANK_PAGES];
+extern __thread unsigned char * mem_write_pages[MEM_MAX_BANKS * MEM_BANK_PAGES];
+extern const unsigned char mem_zero_page[MEM_PAGE_SIZE];
+extern __thread unsigned int mem_size;
+extern __thread unsigned int mem_banks;
+extern int mem_stats_enabled;
+
+// Public Functions
+void mem_reset();
+unsigned char * mem_page_alloc(unsigned int page);
+int mem_map_image(const char * filename);
+int mem_write_image(const char * filename);
+int mem_write_diff(const char * filename);
+void mem_report();
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: LW/SW opcode and its RD and RT fields
+// Outputs: Bank accessed, taken from the field the instruction does not
+//          otherwise use (RT of LW, RD of SW) once banks are enabled
+// /////////////////////////////////////////////////////////////////
+static inline unsigned int mem_bank(unsigned short int opcode, unsigned int rd, unsigned int rt) {
+
+    if (mem_banks == 1) {
+	return 0;
+    }
+
+    return (opcode == 0x08) ? rt : rd;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Bank and address of a LW/SW
+// Outputs: The "...terminating" message if the access faults, or 0
+// /////////////////////////////////////////////////////////////////
+static inline const char * mem_check(unsigned int bank, unsigned short int addr) {
+
+    if (addr & 0x0001) {
+	return "Address not word aligned...terminating";
+    }
+    if ((addr >= mem_size) || (bank >= mem_banks)) {
+	return "Address out of range...terminating";
+    }
+
+    return 0;
+}
+
+// Big-endian word of data memory, pages never stored to read the
+// zero page or the input image
+static inline short int mem_load(unsigned int bank, unsigned short int addr) {
+    const unsigned char * p = mem_pages[(bank << (16 - MEM_PAGE_BITS)) | (addr >> MEM_PAGE_BITS)] + (addr & (MEM_PAGE_SIZE - 1));
+
+    return (short int)((p[0] << 8) | p[1]);
+}
+
+// Stores a big-endian word at an even address, giving the page its
+// own copy first if it still reads the zero page or the input image
+static inline void mem_store(unsigned int bank, unsigned short int addr, short int value) {
+    unsigned int page = (bank << (16 - MEM_PAGE_BITS)) | (addr >> MEM_PAGE_BITS);
+    unsigned char * p = mem_write_pages[page];
+
+    if (!p) {
+	p = mem_page_alloc(page);
+    }
+    p += addr & (MEM_PAGE_SIZE - 1);
+    p[0] = (value >> 8) & 0x00FF;
+    p[1] = value & 0x00FF;
+}
+
+static inline unsigned char mem_read_byte(unsigned int bank, unsigned short int addr) {
+    return mem_pages[(bank << (16 - MEM_PAGE_BITS)) | (addr >> MEM_PAGE_BITS)][addr & (MEM_PAGE_SIZE - 1)];
+}
+
+static inline void mem_write_byte(unsigned int bank, unsigned short int addr, unsigned char value) {
+    unsigned int page = (bank << (16 - MEM_PAGE_BITS)) | (addr >> MEM_PAGE_BITS);
+
+    if (!mem_write_pages[page]) {
+	mem_page_alloc(page);
+    }
+    mem_write_pages[page][addr & (MEM_PAGE_SIZE - 1)] = value;
+}
+
+#endif
@@ -0,0 +1,55 @@
+// //////////////////////////////////////////////////////////////////
+// File: xmemo.h
+// Description: Memo table of register-only blocks for the fast engine
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xMemo_
+#define _xMemo_
+
+#include "xlibrary.h"
+
+// Table size when --memoize is given without one
+#define MEMO_DEFAULT_KB 1024
+// Lookups a block gets to show that memoizing it pays off
+#define MEMO_TRIAL 256
+
+// Outcome of one block for one set of live-in registers
+struct memo_entry {
+    int block;				// Index into blocks, -1 when empty
+    unsigned short int next;		// program_counter after the block
+    short int in[8];			// Live-in registers, the rest zero
+    short int out[8];			// Registers after the block
+};
+
+extern __thread int memo_enabled;
+extern __thread long memo_kb;
+extern __thread struct memo_entry * memo_table;
+extern __thread unsigned long memo_mask;
+extern __thread unsigned long long memo_lookups;
+extern __thread unsigned long long memo_hits;
+extern __thread unsigned long long memo_stores;
+extern __thread unsigned long long memo_rejected;
+
+// Public Functions
+int memo_open();
+void memo_close();
+void memo_report();
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Block index and its live-in registers
+// Outputs: The one entry that may hold them
+// /////////////////////////////////////////////////////////////////
+static inline struct memo_entry * memo_slot(int block, const short int * key) {
+    unsigned int hash = 2166136261u ^ (unsigned int)block;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+	hash = (hash ^ (unsigned short int)key[i]) * 16777619u;
+    }
+
+    return &memo_table[(hash ^ (hash >> 15)) & memo_mask];
+}
+
+#endif
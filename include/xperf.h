@@ -0,0 +1,46 @@
+// //////////////////////////////////////////////////////////////////
+// File: xperf.h
+// Description: Optional instructions that let a guest program read
+//              the simulator's counters and mark regions whose stats
+//              are reported on their own (--perf-isa)
+//
+//              RDCYC  0x0A  RD <- 16 bits of the cycle count, IMM8 bits
+//                           1-0 select which (0 lowest)
+//              RDINST 0x0B  RD <- 16 bits of the instruction count
+//              RDEVT  0x0F  RD <- 16 bits of one stats counter, IMM8
+//                           bits 4-0 are its Instruction_Name and bits
+//                           6-5 select which 16 bits
+//              MARK   0x19  Begins region IMM8 bits 4-0, or ends it
+//                           when IMM8 bit 7 is set
+//
+//              Counts are of the instructions before the one reading
+//              them. The extension instructions are not counted
+//              themselves, so measuring leaves the stats unchanged.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xPerf_
+#define _xPerf_
+
+#include "xlibrary.h"
+
+// Regions MARK can number
+#define PERF_REGIONS 32
+
+// Non-zero when the extension instructions are enabled
+extern __thread int perf_isa_enabled;
+// Non-zero once a MARK ran since the last reset
+extern __thread int perf_marked;
+
+// Public Functions
+void perf_reset();
+int perf_opcode(unsigned short int opcode);
+short int perf_execute(short int inst, unsigned short int opcode);
+short int x_rdcyc(short int inst);
+short int x_rdinst(short int inst);
+short int x_rdevt(short int inst);
+short int x_mark(short int inst);
+void perf_write(Json::Value & array);
+
+#endif
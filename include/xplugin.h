@@ -0,0 +1,42 @@
+/* //////////////////////////////////////////////////////////////////
+ * File: xplugin.h
+ * Description: C interface for instrumentation plugins loaded at run
+ *              time with xsim --plugin=file.so[:args]
+ * Author: ZDHull
+ * Date: 2026/10/19
+ * ////////////////////////////////////////////////////////////////// */
+
+#ifndef _xPlugin_
+#define _xPlugin_
+
+#define XSIM_PLUGIN_VERSION 2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Callbacks a plugin fills in, any of them may be left NULL.
+ * on_instruction runs before the instruction at pc executes, the others
+ * after it completed successfully. on_halt runs once when execution
+ * stops, after a HALT or an error. */
+struct xsim_plugin {
+    unsigned int version;
+    void * data;
+    void (*on_instruction)(void * data, unsigned short pc, unsigned short inst);
+    void (*on_mem_read)(void * data, unsigned short pc, unsigned short addr, short value);
+    void (*on_mem_write)(void * data, unsigned short pc, unsigned short addr, short old_value, short new_value);
+    void (*on_branch)(void * data, unsigned short pc, unsigned short target, int taken);
+    void (*on_halt)(void * data, const short * registers, const unsigned long long * clock_cycles);
+};
+
+/* Every plugin exports this function. It receives a zeroed structure
+ * whose version is XSIM_PLUGIN_VERSION, the text after ':' in the option
+ * (or ""), and returns 0 on success. */
+typedef int (*xsim_plugin_init_fn)(struct xsim_plugin * plugin, const char * args);
+#define XSIM_PLUGIN_INIT "xsim_plugin_init"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,21 @@
+// //////////////////////////////////////////////////////////////////
+// File: xprofile.h
+// Description: Exact per-PC, basic block and call path profiler
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xProfile_
+#define _xProfile_
+
+#include "xlibrary.h"
+
+// Set when profiling is requested on the command line
+extern int profile_enabled;
+
+// Public Functions
+void profile_reset();
+void profile_update(unsigned short int pc, unsigned short int inst, unsigned short int next_pc);
+void profile_write(const char * basename);
+
+#endif
@@ -0,0 +1,78 @@
+// //////////////////////////////////////////////////////////////////
+// File: xresults.h
+// Description: Columnar binary results file that runs append one row
+//              to, for sweeps too large for one output file per run.
+//
+//              The file is a 4096 byte header followed by row groups of
+//              RESULTS_GROUP_ROWS rows. Within a group each column is
+//              one array, so column c of row r is the value at
+//                header_size + (r / group_rows) * group_bytes
+//                + column[c].offset + (r % group_rows) * width
+//              and an analysis maps the file and reads whole arrays.
+//              Values are in host byte order; endian tells a reader on
+//              another host to swap. Rows past "rows" are unused.
+//
+//              Program and configuration names are stored once, in
+//              FILE.dict, one per line; the program and config columns
+//              hold the line number. Appends from several processes or
+//              threads are serialized with flock() on FILE.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xResults_
+#define _xResults_
+
+#include "xlibrary.h"
+#include <string>
+#include <map>
+
+#define RESULTS_MAGIC "XSIMRES"
+#define RESULTS_VERSION 1
+#define RESULTS_ENDIAN 0x01020304
+#define RESULTS_HEADER_SIZE 4096
+#define RESULTS_GROUP_ROWS 4096
+// 22 instruction counts, instructions, cycles, program, config, exit,
+// pc and 8 registers
+#define RESULTS_COLUMNS 36
+#define RESULTS_NAME_SIZE 24
+
+// Column types
+enum Results_Type {RESULTS_U64 = 1, RESULTS_U32, RESULTS_I32, RESULTS_U16, RESULTS_I16};
+
+struct results_column {
+    char name[RESULTS_NAME_SIZE];	// Output file key, NUL padded
+    unsigned int type;			// Results_Type
+    unsigned int offset;		// Bytes from the start of a group
+};
+
+struct results_header {
+    char magic[8];			// RESULTS_MAGIC
+    unsigned int version;
+    unsigned int columns;		// Entries of column
+    unsigned int group_rows;		// Rows per group
+    unsigned int header_size;		// Bytes before the first group
+    unsigned long long group_bytes;	// Bytes per group
+    unsigned long long rows;		// Rows appended
+    unsigned int endian;		// RESULTS_ENDIAN as written
+    unsigned int reserved[5];
+    struct results_column column[RESULTS_COLUMNS];
+};
+
+// An open results file and the names of its dictionary
+struct results_file {
+    int fd;				// Results file
+    int dict_fd;			// FILE.dict
+    off_t dict_size;			// Bytes of FILE.dict read
+    std::map<std::string, unsigned int> ids;	// Dictionary
+    struct results_header * header;	// Mapped header
+    char * group;			// Mapped row group
+    unsigned long long group_index;	// Which one
+};
+
+// Public Functions
+int results_open(struct results_file * results, const char * filename);
+int results_append(struct results_file * results, const char * program, const char * config, int exit_code);
+void results_close(struct results_file * results);
+
+#endif
@@ -0,0 +1,51 @@
+// //////////////////////////////////////////////////////////////////
+// File: xsample.h
+// Description: Statistical sampling profiler for guest code
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xSample_
+#define _xSample_
+
+#include "xlibrary.h"
+#include <signal.h>
+
+// Default time between samples in microseconds of CPU time
+#define SAMPLE_DEFAULT_USEC 1000
+
+// Set when sampling is requested on the command line
+extern int sample_enabled;
+extern long sample_interval_usec;
+
+// Guest PC and call depth as last published by the engine; the SIGPROF
+// handler reads only these
+extern volatile sig_atomic_t sample_pc;
+extern volatile sig_atomic_t sample_depth;
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Address of the instruction about to execute
+// /////////////////////////////////////////////////////////////////
+static inline void sample_fetch(unsigned short int pc) {
+    sample_pc = pc;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Opcode of a jump that completed
+// Description: JALR enters a call and JR leaves one
+// /////////////////////////////////////////////////////////////////
+static inline void sample_jump(unsigned short int opcode) {
+    if (opcode == 0x13) {
+	sample_depth = sample_depth + 1;
+    }
+    else if ((opcode == 0x0C) && (sample_depth > 0)) {
+	sample_depth = sample_depth - 1;
+    }
+}
+
+// Public Functions
+int sample_start();
+void sample_stop();
+void sample_report();
+
+#endif
@@ -0,0 +1,30 @@
+// //////////////////////////////////////////////////////////////////
+// File: xselfprof.h
+// Description: Host time spent by the simulator itself
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xSelfProf_
+#define _xSelfProf_
+
+#include "xlibrary.h"
+
+// Buckets charged while executing, the first 22 follow Instruction_Name
+enum SelfProf_Bucket {SP_INVALID = 22, SP_DISPATCH, SP_TRACE, SP_NUM_BUCKETS};
+// Whole program phases
+enum SelfProf_Phase {SP_LOAD, SP_CONFIG, SP_EXEC, SP_OUTPUT, SP_NUM_PHASES};
+
+// Set when self profiling is requested on the command line
+extern int selfprof_enabled;
+// Cleared when the engine does not charge the per-handler buckets
+extern int selfprof_buckets;
+
+// Public Functions
+void selfprof_init();
+void selfprof_phase_begin(int phase);
+void selfprof_phase_end(int phase);
+int selfprof_switch(int bucket);
+void selfprof_report();
+
+#endif
@@ -0,0 +1,31 @@
+// //////////////////////////////////////////////////////////////////
+// File: xserve.h
+// Description: Simulation daemon answering run requests on a Unix
+//              domain socket
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xServe_
+#define _xServe_
+
+#include "xlibrary.h"
+
+// Requests waiting for a worker before reading and accepting stop
+#define SERVE_DEFAULT_QUEUE 64
+// Connections open at once before accepting stops
+#define SERVE_MAX_CONNECTIONS 1024
+// Time limit of every run unless --max-seconds sets another
+#define SERVE_DEFAULT_SECONDS 60
+// Programs and configurations kept parsed
+#define SERVE_CACHE_ENTRIES 256
+// Longest request line
+#define SERVE_MAX_REQUEST (4 << 20)
+// Seconds a connection may wait between requests, and a client may
+// take to read an answer
+#define SERVE_IDLE_SECONDS 30
+
+// Public Functions
+int serve(const char * path, int workers, int queue, long long limit_instructions, double limit_seconds);
+
+#endif
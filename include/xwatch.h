@@ -0,0 +1,39 @@
+// //////////////////////////////////////////////////////////////////
+// File: xwatch.h
+// Description: Data memory watchpoints
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#ifndef _xWatch_
+#define _xWatch_
+
+#include "xlibrary.h"
+
+// Most watchpoints that can be set
+#define MAX_WATCH 64
+
+// Kinds of access a watchpoint reacts to
+#define WATCH_READ 1
+#define WATCH_WRITE 2
+#define WATCH_CHANGE 4
+
+// One bit per data memory byte, set when any watchpoint covers it
+extern unsigned long long watch_bitmap[MEM_SIZE/64];
+
+// Watchpoints set
+extern int watch_count;
+
+// Public Functions
+int watch_add(const char * spec);
+int watch_hit(int kind, unsigned short int addr, short int old_value, short int new_value);
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Byte address of an access
+// Outputs: Non-zero if a watchpoint may cover the address
+// /////////////////////////////////////////////////////////////////
+static inline int watch_test(unsigned short int addr) {
+    return (watch_bitmap[addr >> 6] >> (addr & 63)) & 1;
+}
+
+#endif
@@ -0,0 +1,379 @@
+// //////////////////////////////////////////////////////////////////
+// File: libxsim.cpp
+// Description: The C interface of include/libxsim.h. An instance is
+//              the calling thread's simulator state plus the guest
+//              output it captured; the calls are the steps main() and
+//              the --serve daemon take, with results copied into plain
+//              structs instead of the output file's Json::Value.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "libxsim.h"
+#include "xcore.h"
+#include "xengine.h"
+#include "xfast.h"
+#include "xblock.h"
+#include "xmemo.h"
+#include "xmem.h"
+#include "xperf.h"
+#include <sstream>
+#include <climits>
+
+using namespace std;
+
+struct xsim {
+    ostringstream output;	// Guest output since load or reset
+    string text;		// Copy of output returned by xsim_output
+    int halted;			// Executed HALT since load or reset
+};
+
+static __thread struct xsim * xsim_current = 0;	// Instance of this thread
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Instance passed to a call
+// Outputs: Non-zero if it is the calling thread's instance
+// /////////////////////////////////////////////////////////////////
+static int xsim_owned(xsim * x) {
+
+    return x && (x == xsim_current);
+}
+
+// /////////////////////////////////////////////////////////////////
+// Outputs: Status of the run that just stopped
+// /////////////////////////////////////////////////////////////////
+static int xsim_status(xsim * x, short int halt_all) {
+
+    if (halt_all) {
+	x->halted = 1;
+	return XSIM_HALTED;
+    }
+    if (program_counter == (unsigned short int)-1) {
+	return XSIM_FAULT;
+    }
+    if (limit_hit == LIMIT_SECONDS) {
+	return XSIM_TIME_LIMIT;
+    }
+
+    return XSIM_INSTRUCTION_LIMIT;
+}
+
+xsim * xsim_create(void) {
+    struct xsim_config config;	// Settings of a new instance
+
+    if (xsim_current) {
+	return 0;
+    }
+
+    xsim_current = new xsim;
+    xsim_current->halted = 0;
+    guest_out = &xsim_current->output;
+    trace_enabled = 0;
+
+    xsim_default_config(&config);
+    xsim_configure(xsim_current, &config);
+    block_reset();
+
+    return xsim_current;
+}
+
+void xsim_destroy(xsim * x) {
+
+    if (!xsim_owned(x)) {
+	return;
+    }
+
+    if (memo_enabled) {
+	memo_close();
+	memo_enabled = 0;
+    }
+    fast_enabled = 0;
+    perf_isa_enabled = 0;
+    mem_reset();
+    guest_out = &cout;
+
+    delete x;
+    xsim_current = 0;
+
+    return;
+}
+
+void xsim_default_config(struct xsim_config * config) {
+    int i;			// Count variable
+
+    for (i = 0; i < 8; i++) {
+	config->latency[i] = 1;
+    }
+    config->engine = XSIM_ENGINE_REFERENCE;
+    config->memoize_kb = 0;
+    config->max_instructions = 0;
+    config->max_seconds = 0;
+    config->mem_size = MEM_SIZE;
+    config->mem_banks = 1;
+    config->perf_isa = 0;
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Checked as main() checks the options of the same
+//              names. The memo table is rebuilt, entries of another
+//              size or program cannot be reused.
+// /////////////////////////////////////////////////////////////////
+int xsim_configure(xsim * x, const struct xsim_config * config) {
+
+    if (!xsim_owned(x) || !config) {
+	return XSIM_ERROR;
+    }
+    if (((config->engine != XSIM_ENGINE_REFERENCE) && (config->engine != XSIM_ENGINE_FAST)) ||
+	(config->memoize_kb < 0) || (config->max_instructions < 0) || (config->max_seconds < 0) ||
+	(config->mem_size < 2) || (config->mem_size > MEM_SIZE) || (config->mem_size & 0x0001) ||
+	(config->mem_banks < 1) || (config->mem_banks > MEM_MAX_BANKS)) {
+	return XSIM_ERROR;
+    }
+
+    memcpy(latency_vals, config->latency, sizeof(latency_vals));
+    fast_enabled = (config->engine == XSIM_ENGINE_FAST) || (config->memoize_kb > 0);
+    max_instructions = config->max_instructions;
+    max_seconds = config->max_seconds;
+    mem_size = config->mem_size;
+    mem_banks = config->mem_banks;
+    perf_isa_enabled = (config->perf_isa != 0);
+
+    if (memo_enabled) {
+	memo_close();
+	memo_enabled = 0;
+    }
+    if (config->memoize_kb > 0) {
+	memo_kb = config->memoize_kb;
+	memo_enabled = (memo_open() == 0);
+    }
+
+    return xsim_reset(x);
+}
+
+int xsim_load(xsim * x, const char * text, size_t length) {
+    istringstream in;		// Program text
+
+    if (!xsim_owned(x) || (!text && length)) {
+	return XSIM_ERROR;
+    }
+
+    in.str(string(text ? text : "", length));
+    load_program(in);
+
+    // Blocks and memoized results belong to the previous program
+    block_reset();
+    if (memo_enabled) {
+	memo_close();
+	memo_enabled = (memo_open() == 0);
+    }
+
+    return xsim_reset(x);
+}
+
+int xsim_load_binary(xsim * x, const unsigned char * code, size_t length) {
+
+    if (!xsim_owned(x) || (length > MEM_SIZE) || (length & 0x0001) || (!code && length)) {
+	return XSIM_ERROR;
+    }
+
+    if ((size_t)program_size > length) {
+	memset(&inst_memory[length], 0, program_size - length);
+    }
+    if (length) {
+	memcpy(inst_memory, code, length);
+    }
+    program_size = length;
+
+    block_reset();
+    if (memo_enabled) {
+	memo_close();
+	memo_enabled = (memo_open() == 0);
+    }
+
+    return xsim_reset(x);
+}
+
+int xsim_reset(xsim * x) {
+
+    if (!xsim_owned(x)) {
+	return XSIM_ERROR;
+    }
+
+    reset_state();
+    x->halted = 0;
+    x->output.str("");
+
+    return 0;
+}
+
+int xsim_run(xsim * x) {
+    null_tool no_tool;		// Uninstrumented engine
+    short int halt_all;		// Halting Flag
+
+    if (!xsim_owned(x)) {
+	return XSIM_ERROR;
+    }
+    if (x->halted) {
+	return XSIM_HALTED;
+    }
+    if (program_counter == (unsigned short int)-1) {
+	return XSIM_FAULT;
+    }
+
+    limit_hit = LIMIT_NONE;
+    periodic_start();
+    halt_all = fast_enabled ? run_fast() : run_engine(no_tool);
+
+    return xsim_status(x, halt_all);
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: The count is run as an instruction limit, so the
+//              configured limits do not apply to steps
+// /////////////////////////////////////////////////////////////////
+int xsim_step(xsim * x, unsigned long long count) {
+    null_tool no_tool;		// Uninstrumented engine
+    long long saved_instructions;	// Configured limits
+    double saved_seconds;
+    short int halt_all;		// Halting Flag
+    int status;
+
+    if (!xsim_owned(x) || (count == 0) || (count > (unsigned long long)LLONG_MAX)) {
+	return XSIM_ERROR;
+    }
+    if (x->halted) {
+	return XSIM_HALTED;
+    }
+    if (program_counter == (unsigned short int)-1) {
+	return XSIM_FAULT;
+    }
+
+    saved_instructions = max_instructions;
+    saved_seconds = max_seconds;
+    max_instructions = count;
+    max_seconds = 0;
+
+    limit_hit = LIMIT_NONE;
+    periodic_start();
+    halt_all = run_engine(no_tool);
+
+    max_instructions = saved_instructions;
+    max_seconds = saved_seconds;
+
+    status = xsim_status(x, halt_all);
+    if (status == XSIM_INSTRUCTION_LIMIT) {
+	limit_hit = LIMIT_NONE;
+	status = XSIM_STEPPED;
+    }
+
+    return status;
+}
+
+int xsim_registers(xsim * x, struct xsim_registers * regs) {
+
+    if (!xsim_owned(x) || !regs) {
+	return XSIM_ERROR;
+    }
+
+    memcpy(regs->r, reg_file, sizeof(regs->r));
+    regs->pc = program_counter;
+
+    return 0;
+}
+
+int xsim_stats(xsim * x, struct xsim_stats * stats) {
+
+    if (!xsim_owned(x) || !stats) {
+	return XSIM_ERROR;
+    }
+
+    memcpy(stats->count, clock_cycles, sizeof(stats->count));
+    count_totals(&stats->instructions, &stats->cycles);
+
+    return 0;
+}
+
+int xsim_read_data(xsim * x, unsigned int bank, unsigned int addr, unsigned char * buffer, size_t length) {
+    size_t i;			// Count variable
+
+    if (!xsim_owned(x) || (bank >= mem_banks) || (addr > mem_size) || (length > mem_size - addr) ||
+	(!buffer && length)) {
+	return XSIM_ERROR;
+    }
+
+    for (i = 0; i < length; i++) {
+	buffer[i] = mem_read_byte(bank, addr + i);
+    }
+
+    return 0;
+}
+
+int xsim_write_data(xsim * x, unsigned int bank, unsigned int addr, const unsigned char * buffer, size_t length) {
+    size_t i;			// Count variable
+
+    if (!xsim_owned(x) || (bank >= mem_banks) || (addr > mem_size) || (length > mem_size - addr) ||
+	(!buffer && length)) {
+	return XSIM_ERROR;
+    }
+
+    for (i = 0; i < length; i++) {
+	mem_write_byte(bank, addr + i, buffer[i]);
+    }
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: FNV-1a over the index and bytes of every page that is
+//              not all zero, so how a page came to hold its bytes
+//              (stored to, mapped, never touched) does not matter
+// /////////////////////////////////////////////////////////////////
+unsigned long long xsim_data_digest(xsim * x) {
+    unsigned long long hash = 14695981039346656037ULL;
+    const unsigned char * page;		// Page read at the index
+    unsigned int i, j;			// Count variables
+
+    if (!xsim_owned(x)) {
+	return 0;
+    }
+
+    for (i = 0; i < mem_banks * MEM_BANK_PAGES; i++) {
+	page = mem_pages[i];
+	if (page == mem_zero_page) {
+	    continue;
+	}
+	for (j = 0; (j < MEM_PAGE_SIZE) && !page[j]; j++) {
+	}
+	if (j == MEM_PAGE_SIZE) {
+	    continue;
+	}
+	hash = (hash ^ i) * 1099511628211ULL;
+	for (j = 0; j < MEM_PAGE_SIZE; j++) {
+	    hash = (hash ^ page[j]) * 1099511628211ULL;
+	}
+    }
+
+    return hash;
+}
+
+const char * xsim_output(xsim * x) {
+
+    if (!xsim_owned(x)) {
+	return 0;
+    }
+
+    x->text = x->output.str();
+
+    return x->text.c_str();
+}
+
+const char * xsim_stat_name(int index) {
+
+    if ((index < 0) || (index >= XSIM_STATS)) {
+	return 0;
+    }
+
+    return stat_names[index];
+}
@@ -0,0 +1,1007 @@
+// //////////////////////////////////////////////////////////////////
+// File: xanalyze.cpp
+// Description: --analyze builds the control-flow graph of the loaded
+//              program from the branch and jump encodings without
+//              running it. Register values are followed by constant
+//              propagation: registers start at zero, LW always loads an
+//              unknown value, and paths that meet keep only the values
+//              they agree on. That resolves branches on constants and
+//              JR/JALR through constant registers, and a self loop that
+//              steps counters by constants gets its trip count solved.
+//              The report lists the blocks, loops, unreachable code,
+//              invalid opcodes, indirect jumps, instructions that always
+//              fault, the static instruction mix and cycle estimates.
+//              When the reachable code is a single path it also
+//              predicts the exact stats of a run. Otherwise the
+//              program is walked one instruction at a time with
+//              concrete values for up to ANALYZE_WALK_STEPS steps, so
+//              loops and calls that only depend on constants still get
+//              an exact prediction.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xanalyze.h"
+#include "xblock.h"
+#include "xmem.h"
+#include "xperf.h"
+#include <vector>
+
+using namespace std;
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread int latency_vals[8];
+extern __thread int program_size;
+// //////////////////////////////////////////
+
+// What the analysis knows about a register
+#define REG_UNSET 0		// No path has reached it
+#define REG_CONST 1		// Same value on every path
+#define REG_VARYING 2		// Differs between paths or came from memory
+
+// Instructions the concrete walk runs before it gives up
+#define ANALYZE_WALK_STEPS 10000000ULL
+
+// Registers at one point of the program
+struct reg_state {
+    unsigned char kind[8];	// REG_* of each register
+    short int value[8];		// Value of REG_CONST registers
+};
+
+// One block, leaders are address 0, branch and jump targets and the
+// instruction after any control transfer
+struct cfg_block {
+    unsigned short int start;	// Address of the first instruction
+    unsigned int first;		// Index of the first instruction in code
+    unsigned int length;	// Instructions
+    int reachable;		// Some path from address 0 reaches it
+    struct reg_state in;	// Registers on entry
+    unsigned long long cycles;	// Latency of one pass
+    int loop_depth;		// Loops containing the block
+};
+
+// Where execution can go after a block
+struct cfg_exit {
+    int count;			// Successors
+    int succ[2];		// Successor blocks
+    struct reg_state state[2];	// Registers on each edge
+    unsigned int wrap[2];	// Zero words run past the program on each edge
+    int fault;			// Instruction that always faults, or -1
+    const char * reason;	// Why it faults
+    int indirect;		// JR/JALR target is not constant
+    int target;			// Constant JR/JALR target, or -1
+    int call;			// Ends in JALR
+    int outside;		// Target outside the program, or -1
+    int split;			// Resolved target that is not a leader, or -1
+    unsigned long long trips;	// Trips of a bounded self loop, or 0
+};
+
+int analyze_enabled = 0;		// Analyze instead of executing
+
+static vector<struct xop> code;		// Every instruction of the program
+static vector<struct cfg_block> cfg;	// Blocks in address order
+static vector<int> block_at;		// Block starting at each instruction, or -1
+static vector<int> leader;		// Instructions that start a block
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: One decoded instruction
+// Outputs: Its cycles as counted by write_output
+// /////////////////////////////////////////////////////////////////
+static unsigned long long analyze_latency(const struct xop * op) {
+
+    if (op->opcode <= 0x07) {
+	return latency_vals[op->opcode];
+    }
+
+    return (get_inst_name(op->opcode) >= 0) ? 1 : 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Register state and one register
+// Outputs: Non-zero if the register holds a known value
+// /////////////////////////////////////////////////////////////////
+static inline int reg_known(const struct reg_state * st, int r) {
+
+    return st->kind[r] == REG_CONST;
+}
+
+static inline void reg_set(struct reg_state * st, int r, short int value) {
+
+    st->kind[r] = REG_CONST;
+    st->value[r] = value;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: State on an edge and the state at the block it enters
+// Outputs: Non-zero if the block's state changed
+// /////////////////////////////////////////////////////////////////
+static int reg_meet(struct reg_state * into, const struct reg_state * from) {
+    int changed = 0;
+    int r;
+
+    for (r = 0; r < 8; r++) {
+	if ((from->kind[r] == REG_UNSET) || (into->kind[r] == REG_VARYING)) {
+	    continue;
+	}
+	if (into->kind[r] == REG_UNSET) {
+	    into->kind[r] = from->kind[r];
+	    into->value[r] = from->value[r];
+	    changed = 1;
+	}
+	else if ((from->kind[r] == REG_VARYING) || (from->value[r] != into->value[r])) {
+	    into->kind[r] = REG_VARYING;
+	    changed = 1;
+	}
+    }
+
+    return changed;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: One instruction and the registers before it
+// Outputs: 0 if the instruction always faults, with the reason
+// Description: Updates the registers the way the instruction would.
+//              Control transfers are left to analyze_block.
+// /////////////////////////////////////////////////////////////////
+static int analyze_step(const struct xop * op, struct reg_state * st, const char ** reason) {
+    short int a, b;			// Source values
+
+    switch (op->opcode) {
+	case (0x00):
+	case (0x01):
+	case (0x02):
+	case (0x03):
+	case (0x04):
+	case (0x05):
+	case (0x06):
+	case (0x07):
+	    if (((op->opcode == 0x04) || (op->opcode == 0x06)) && reg_known(st, op->rt) && (st->value[op->rt] == 0)) {
+		*reason = (op->opcode == 0x04) ? "divide by 0" : "mod by 0";
+		return 0;
+	    }
+	    // x - x is zero whatever x holds
+	    if ((op->opcode == 0x01) && (op->rs == op->rt)) {
+		reg_set(st, op->rd, 0);
+		break;
+	    }
+	    if (!reg_known(st, op->rs) || !reg_known(st, op->rt)) {
+		st->kind[op->rd] = REG_VARYING;
+		break;
+	    }
+	    a = st->value[op->rs];
+	    b = st->value[op->rt];
+	    switch (op->opcode) {
+		case (0x00):
+		    reg_set(st, op->rd, a + b);
+		    break;
+		case (0x01):
+		    reg_set(st, op->rd, a - b);
+		    break;
+		case (0x02):
+		    reg_set(st, op->rd, a & b);
+		    break;
+		case (0x03):
+		    reg_set(st, op->rd, ~(a | b));
+		    break;
+		case (0x04):
+		    reg_set(st, op->rd, a / b);
+		    break;
+		case (0x05):
+		    reg_set(st, op->rd, a * b);
+		    break;
+		case (0x06):
+		    reg_set(st, op->rd, a % b);
+		    break;
+		default:
+		    reg_set(st, op->rd, exp_value(a, b));
+		    break;
+	    }
+	    break;
+	case (0x08):
+	case (0x09):
+	    if (reg_known(st, op->rs) && (st->value[op->rs] & 0x0001)) {
+		*reason = "address not word aligned";
+		return 0;
+	    }
+	    if ((mem_bank(op->opcode, op->rd, op->rt) >= mem_banks) ||
+		(reg_known(st, op->rs) && ((unsigned short int)st->value[op->rs] >= mem_size))) {
+		*reason = "address out of range";
+		return 0;
+	    }
+	    if (op->opcode == 0x08) {
+		st->kind[op->rd] = REG_VARYING;
+	    }
+	    break;
+	case (0x10):
+	case (0x11):
+	    reg_set(st, op->rd, op->imm);
+	    break;
+	case (0x12):
+	    if (reg_known(st, op->rd)) {
+		reg_set(st, op->rd, (0xFF00 & (op->imm << 8)) | (0x00FF & st->value[op->rd]));
+	    }
+	    break;
+	// Counters read by --perf-isa
+	case (0x0A):
+	case (0x0B):
+	case (0x0F):
+	    if (perf_opcode(op->opcode)) {
+		st->kind[op->rd] = REG_VARYING;
+	    }
+	    break;
+    }
+
+    return 1;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Counts to fill in
+// Outputs: Non-zero if the walk reached HALT or a fault, with why it
+//          ended and the address it ended at
+// Description: Runs the program from address 0 with every register
+//              cleared, the way the engine would, as long as every
+//              branch, jump target, memory address and divisor is a
+//              constant. Stores are kept on the side and loads of
+//              words not stored to read data memory as it is before
+//              the run. Counters read by --perf-isa are unknown.
+// /////////////////////////////////////////////////////////////////
+static int analyze_walk(unsigned long long * mix, unsigned long long * insts, unsigned long long * cycles, const char ** stop, int * stop_pc) {
+    struct reg_state st;		// Registers
+    struct xop op;			// Instruction at pc
+    vector<unsigned char> kind;		// REG_* of each stored word, REG_UNSET if not stored
+    vector<short int> value;		// Value of each stored word
+    unsigned long long steps;		// Instructions walked
+    unsigned short int pc;		// Address of the instruction
+    unsigned short int addr;		// LW/SW address
+    unsigned int word;			// LW/SW word across the banks
+    short int stored;			// Word SW stores
+    unsigned char stored_kind;		// What is known about it
+    const char * reason;		// Why an instruction faults
+    int name;				// Instruction_Name
+    int r;				// Register
+
+    for (r = 0; r < 8; r++) {
+	reg_set(&st, r, 0);
+    }
+    kind.assign((size_t)mem_banks * MEM_SIZE / 2, REG_UNSET);
+    value.assign((size_t)mem_banks * MEM_SIZE / 2, 0);
+    memset(mix, 0, 22 * sizeof(unsigned long long));
+    *insts = 0;
+    *cycles = 0;
+
+    pc = 0;
+    for (steps = 0; steps < ANALYZE_WALK_STEPS; steps++) {
+	*stop_pc = pc;
+	if (pc & 0x0001) {
+	    *stop = "leaves the program";
+	    return 0;
+	}
+	block_op(pc, &op);
+
+	// Whether these fault depends on the unknown value
+	if (((op.opcode == 0x04) || (op.opcode == 0x06)) && !reg_known(&st, op.rt)) {
+	    *stop = "divide by a varying register";
+	    return 0;
+	}
+	if (((op.opcode == 0x08) || (op.opcode == 0x09)) && !reg_known(&st, op.rs)) {
+	    *stop = "memory access at a varying address";
+	    return 0;
+	}
+
+	// The address register may be the destination of a LW
+	addr = (unsigned short int)st.value[op.rs];
+	stored = st.value[op.rt];
+	stored_kind = st.kind[op.rt];
+	if (!analyze_step(&op, &st, &reason)) {
+	    *stop = "fault";
+	    return 1;
+	}
+	if ((op.opcode == 0x08) || (op.opcode == 0x09)) {
+	    word = (mem_bank(op.opcode, op.rd, op.rt) * MEM_SIZE + addr) / 2;
+	    if (op.opcode == 0x09) {
+		kind[word] = stored_kind;
+		value[word] = stored;
+	    }
+	    else if (kind[word] == REG_UNSET) {
+		reg_set(&st, op.rd, mem_load(mem_bank(op.opcode, op.rd, op.rt), addr));
+	    }
+	    else if (kind[word] == REG_CONST) {
+		reg_set(&st, op.rd, value[word]);
+	    }
+	}
+
+	name = get_inst_name(op.opcode);
+	if (name == N_HALT) {
+	    mix[name] = 1;
+	    *insts += 1;
+	    *cycles += 1;
+	    *stop = "halt";
+	    return 1;
+	}
+	else if (name >= 0) {
+	    mix[name]++;
+	    *insts += 1;
+	    *cycles += analyze_latency(&op);
+	}
+
+	switch (op.opcode) {
+	    case (0x14):
+	    case (0x15):
+	    case (0x16):
+	    case (0x17):
+		if (!reg_known(&st, op.rd)) {
+		    *stop = "branch on a varying register";
+		    return 0;
+		}
+		if (((op.opcode == 0x14) && (st.value[op.rd] > 0)) ||
+		    ((op.opcode == 0x15) && (st.value[op.rd] < 0)) ||
+		    ((op.opcode == 0x16) && (st.value[op.rd] != 0)) ||
+		    ((op.opcode == 0x17) && (st.value[op.rd] == 0))) {
+		    pc = op.target;
+		}
+		else {
+		    pc += 2;
+		}
+		break;
+	    case (0x18):
+		pc = op.target;
+		break;
+	    case (0x13):
+		reg_set(&st, op.rd, pc + 2);
+		// Fall through, the target is read after the link is written
+	    case (0x0C):
+		if (!reg_known(&st, op.rs)) {
+		    *stop = "indirect jump";
+		    return 0;
+		}
+		pc = (unsigned short int)st.value[op.rs];
+		break;
+	    default:
+		pc += 2;
+		break;
+	}
+    }
+
+    *stop_pc = pc;
+    *stop = "step budget reached";
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Exit being built, target address and registers on the edge
+// /////////////////////////////////////////////////////////////////
+static void analyze_edge(struct cfg_exit * ex, unsigned int addr, const struct reg_state * st) {
+    unsigned int words;			// Zero words up to the end of memory
+
+    if (addr & 0x0001) {
+	ex->outside = addr;
+    }
+    else if (addr >= (unsigned int)program_size) {
+	// Memory past the program holds ADD r0,r0,r0 up to the end, where
+	// execution wraps to 0 with r0 doubled once per word
+	ex->outside = addr;
+	words = (MEM_SIZE - addr) / 2;
+	ex->succ[ex->count] = 0;
+	ex->state[ex->count] = *st;
+	ex->wrap[ex->count] = words;
+	if (reg_known(st, 0)) {
+	    ex->state[ex->count].value[0] = (words >= 16) ? 0 : (short int)(st->value[0] << words);
+	}
+	ex->count++;
+    }
+    else if (block_at[addr >> 1] < 0) {
+	ex->split = addr;
+    }
+    else {
+	ex->succ[ex->count] = block_at[addr >> 1];
+	ex->state[ex->count] = *st;
+	ex->wrap[ex->count] = 0;
+	ex->count++;
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Block and the registers on entry
+// Outputs: Successors and what the block does on the way
+// /////////////////////////////////////////////////////////////////
+static void analyze_block(int index, const struct reg_state * in, struct cfg_exit * ex) {
+    const struct cfg_block * b = &cfg[index];
+    const struct xop * ops = &code[b->first];
+    const struct xop * last = &ops[b->length - 1];
+    struct reg_state st;		// Registers through the block
+    short int values[8];		// Register values for block_trips
+    unsigned short int step[8];		// Per-trip step of each register
+    unsigned int next;			// Address after the block
+    unsigned int i;			// Count variable
+    int r;				// Register
+
+    st = *in;
+    next = b->start + 2 * b->length;
+
+    ex->count = 0;
+    ex->fault = -1;
+    ex->reason = 0;
+    ex->indirect = 0;
+    ex->target = -1;
+    ex->call = 0;
+    ex->outside = -1;
+    ex->split = -1;
+    ex->trips = 0;
+
+    // A counted self loop with known registers leaves by its fall through
+    if (block_loop_kind(ops, b->length, b->start) == LOOP_INDUCTION) {
+	for (i = 0; i + 1 < b->length; i++) {
+	    if (!reg_known(&st, ops[i].rd) || !reg_known(&st, ops[i].rt)) {
+		break;
+	    }
+	}
+	if ((i + 1 == b->length) && reg_known(&st, last->rd)) {
+	    memcpy(values, st.value, sizeof(values));
+	    ex->trips = block_trips(ops, b->length, values, step);
+	}
+	if (ex->trips) {
+	    for (r = 0; r < 8; r++) {
+		st.value[r] = (unsigned short int)(st.value[r] + ex->trips * step[r]);
+	    }
+	    analyze_edge(ex, next, &st);
+	    return;
+	}
+    }
+
+    for (i = 0; i < b->length; i++) {
+	if (!analyze_step(&ops[i], &st, &ex->reason)) {
+	    ex->fault = i;
+	    return;
+	}
+    }
+
+    switch (last->opcode) {
+	case (0x14):
+	case (0x15):
+	case (0x16):
+	case (0x17):
+	    if (!reg_known(&st, last->rd)) {
+		analyze_edge(ex, last->target, &st);
+		analyze_edge(ex, next, &st);
+	    }
+	    else if (((last->opcode == 0x14) && (st.value[last->rd] > 0)) ||
+		     ((last->opcode == 0x15) && (st.value[last->rd] < 0)) ||
+		     ((last->opcode == 0x16) && (st.value[last->rd] != 0)) ||
+		     ((last->opcode == 0x17) && (st.value[last->rd] == 0))) {
+		analyze_edge(ex, last->target, &st);
+	    }
+	    else {
+		analyze_edge(ex, next, &st);
+	    }
+	    break;
+	case (0x18):
+	    analyze_edge(ex, last->target, &st);
+	    break;
+	case (0x0C):
+	    if (reg_known(&st, last->rs)) {
+		ex->target = (unsigned short int)st.value[last->rs];
+		analyze_edge(ex, ex->target, &st);
+	    }
+	    else {
+		ex->indirect = 1;
+	    }
+	    break;
+	case (0x13):
+	    // The callee may change any register before returning
+	    ex->call = 1;
+	    reg_set(&st, last->rd, next);
+	    if (reg_known(&st, last->rs)) {
+		ex->target = (unsigned short int)st.value[last->rs];
+		analyze_edge(ex, ex->target, &st);
+	    }
+	    else {
+		ex->indirect = 1;
+	    }
+	    for (r = 0; r < 8; r++) {
+		st.kind[r] = REG_VARYING;
+	    }
+	    analyze_edge(ex, next, &st);
+	    break;
+	case (0x0D):
+	    break;
+	default:
+	    analyze_edge(ex, next, &st);
+	    break;
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Splits the program into blocks at the leaders
+// /////////////////////////////////////////////////////////////////
+static void analyze_build() {
+    struct cfg_block b;			// Block being built
+    unsigned int n;			// Instructions in the program
+    unsigned int i;			// Count variable
+
+    n = code.size();
+    cfg.clear();
+    block_at.assign(n, -1);
+
+    for (i = 0; i < n; i++) {
+	if (leader[i] || (i == 0) || block_ends(code[i - 1].opcode)) {
+	    b.start = i << 1;
+	    b.first = i;
+	    b.length = 0;
+	    b.reachable = 0;
+	    b.cycles = 0;
+	    b.loop_depth = 0;
+	    memset(&b.in, 0, sizeof(b.in));
+	    block_at[i] = cfg.size();
+	    cfg.push_back(b);
+	}
+	cfg.back().length++;
+	cfg.back().cycles += analyze_latency(&code[i]);
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Outputs: A constant JR/JALR target that is not yet a leader, or -1
+//          once every reachable block has its final entry registers
+// /////////////////////////////////////////////////////////////////
+static int analyze_propagate() {
+    vector<int> work;			// Blocks whose entry changed
+    vector<char> queued;		// Block is in work
+    struct cfg_exit ex;			// Successors of a block
+    struct reg_state unknown;		// Every register varying
+    int anywhere;			// Every block was made reachable
+    int index;				// Block being analyzed
+    int i;				// Count variable
+
+    queued.assign(cfg.size(), 0);
+    for (i = 0; i < 8; i++) {
+	unknown.kind[i] = REG_VARYING;
+	unknown.value[i] = 0;
+    }
+    anywhere = 0;
+
+    // Execution starts at 0 with every register cleared
+    for (i = 0; i < 8; i++) {
+	reg_set(&cfg[0].in, i, 0);
+    }
+    cfg[0].reachable = 1;
+    work.push_back(0);
+    queued[0] = 1;
+
+    while (!work.empty()) {
+	index = work.back();
+	work.pop_back();
+	queued[index] = 0;
+
+	analyze_block(index, &cfg[index].in, &ex);
+	if (ex.split >= 0) {
+	    return ex.split;
+	}
+
+	// An unresolved JR/JALR, or running from an odd address, may land
+	// on any block with anything in the registers
+	if ((ex.indirect || ((ex.outside >= 0) && (ex.outside & 0x0001))) && !anywhere) {
+	    anywhere = 1;
+	    for (i = 0; i < (int)cfg.size(); i++) {
+		if (reg_meet(&cfg[i].in, &unknown) || !cfg[i].reachable) {
+		    cfg[i].reachable = 1;
+		    if (!queued[i]) {
+			work.push_back(i);
+			queued[i] = 1;
+		    }
+		}
+	    }
+	}
+
+	for (i = 0; i < ex.count; i++) {
+	    if (reg_meet(&cfg[ex.succ[i]].in, &ex.state[i]) || !cfg[ex.succ[i]].reachable) {
+		cfg[ex.succ[i]].reachable = 1;
+		if (!queued[ex.succ[i]]) {
+		    work.push_back(ex.succ[i]);
+		    queued[ex.succ[i]] = 1;
+		}
+	    }
+	}
+    }
+
+    return -1;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Live successors of every block
+// Outputs: Loops found, one per header, in header order
+// Description: A depth first walk from address 0 finds the edges back
+//              to a block still on the walk. Each such header's loop
+//              is every block that reaches the edge without passing
+//              through the header.
+// /////////////////////////////////////////////////////////////////
+static void analyze_loops(const vector<vector<int> > & succ, const vector<unsigned long long> & trips, Json::Value & loops) {
+    vector<vector<int> > pred(cfg.size());	// Live predecessors
+    vector<char> state(cfg.size(), 0);		// 0 new, 1 on walk, 2 done
+    vector<unsigned int> next(cfg.size(), 0);	// Next successor to walk
+    vector<vector<int> > latches(cfg.size());	// Back edges into each header
+    vector<int> stack;				// Blocks on the walk
+    vector<int> body;				// Blocks of one loop
+    vector<char> in_loop;			// Block is in body
+    Json::Value obj;
+    unsigned long long insts;			// Instructions in the loop
+    unsigned long long cycles;			// Latency of one pass of every block
+    unsigned int i, j;				// Count variables
+    int b, s;					// Blocks
+
+    for (i = 0; i < cfg.size(); i++) {
+	for (j = 0; j < succ[i].size(); j++) {
+	    pred[succ[i][j]].push_back(i);
+	}
+    }
+
+    stack.push_back(0);
+    state[0] = 1;
+    while (!stack.empty()) {
+	b = stack.back();
+	if (next[b] < succ[b].size()) {
+	    s = succ[b][next[b]++];
+	    if (state[s] == 1) {
+		latches[s].push_back(b);
+	    }
+	    else if (state[s] == 0) {
+		state[s] = 1;
+		stack.push_back(s);
+	    }
+	}
+	else {
+	    state[b] = 2;
+	    stack.pop_back();
+	}
+    }
+
+    for (i = 0; i < cfg.size(); i++) {
+	if (latches[i].empty() && !trips[i]) {
+	    continue;
+	}
+
+	// Walk predecessors back from the latches up to the header
+	in_loop.assign(cfg.size(), 0);
+	body.clear();
+	in_loop[i] = 1;
+	body.push_back(i);
+	stack = latches[i];
+	while (!stack.empty()) {
+	    b = stack.back();
+	    stack.pop_back();
+	    if (in_loop[b]) {
+		continue;
+	    }
+	    in_loop[b] = 1;
+	    body.push_back(b);
+	    for (j = 0; j < pred[b].size(); j++) {
+		stack.push_back(pred[b][j]);
+	    }
+	}
+
+	insts = 0;
+	cycles = 0;
+	for (j = 0; j < body.size(); j++) {
+	    insts += cfg[body[j]].length;
+	    cycles += cfg[body[j]].cycles;
+	    cfg[body[j]].loop_depth++;
+	}
+
+	obj.clear();
+	obj["header"] = cfg[i].start;
+	obj["blocks"] = (int)body.size();
+	obj["instructions"] = (Json::UInt64)insts;
+	obj["body_cycles"] = (Json::UInt64)cycles;
+	if (trips[i]) {
+	    obj["trips"] = (Json::UInt64)trips[i];
+	    obj["cycles"] = (Json::UInt64)(trips[i] * cycles);
+	}
+	loops.append(obj);
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Name of the output file
+// Description: Analyzes the program in instruction memory and writes
+//              the report to the output file, with a summary on stdout
+// /////////////////////////////////////////////////////////////////
+void analyze_write(char * filename) {
+    ofstream outfile;
+    Json::Value root;
+    Json::Value block_array(Json::arrayValue);
+    Json::Value loop_array(Json::arrayValue);
+    Json::Value unreachable_array(Json::arrayValue);
+    Json::Value invalid_array(Json::arrayValue);
+    Json::Value indirect_array(Json::arrayValue);
+    Json::Value fault_array(Json::arrayValue);
+    Json::Value outside_array(Json::arrayValue);
+    Json::Value succ_array;
+    Json::Value static_obj;
+    Json::Value reachable_obj;
+    Json::Value predict_obj;
+    Json::Value predict_stats;
+    Json::Value obj;
+    Json::StyledWriter styledWriter;
+    vector<vector<int> > succ;			// Live successors of each block
+    vector<unsigned long long> trips;		// Trips of bounded self loops
+    vector<struct cfg_exit> exits;		// Final exit of each block
+    vector<char> visited;			// Blocks on the predicted path
+    unsigned long long static_mix[22];		// Every instruction
+    unsigned long long reachable_mix[22];	// Reachable instructions
+    unsigned long long predict_mix[22];		// Predicted run
+    unsigned long long static_cycles;		// One pass of reachable code
+    unsigned long long predict_insts;		// Predicted instructions
+    unsigned long long predict_cycles;		// Predicted cycles
+    unsigned long long times;			// Passes of a block
+    unsigned long long unreachable;		// Unreachable instructions
+    unsigned int n;				// Instructions in the program
+    unsigned int i, j, end;			// Count variables
+    int name;					// Instruction_Name
+    int split;					// Leader found by propagation
+    int index;					// Block on the predicted path
+    int resolved;				// Indirect jumps made constant
+    const char * stop;				// Why prediction stopped
+    int stop_pc;				// Where it stopped, or -1
+    int complete;				// Prediction reached the end
+    unsigned long long walk_mix[22];		// Concrete walk
+    unsigned long long walk_insts;
+    unsigned long long walk_cycles;
+    const char * walk_stop;
+    int walk_pc;
+
+    n = program_size / 2;
+    code.resize(n);
+    leader.assign(n, 0);
+
+    // Static leaders from branch and jump encodings
+    for (i = 0; i < n; i++) {
+	block_op(i << 1, &code[i]);
+	if ((code[i].opcode >= 0x14) && (code[i].opcode <= 0x18) && ((code[i].target >> 1) < n)) {
+	    leader[code[i].target >> 1] = 1;
+	}
+    }
+
+    // Constant JR/JALR targets can add leaders
+    split = -1;
+    if (n > 0) {
+	do {
+	    if (split >= 0) {
+		leader[split >> 1] = 1;
+	    }
+	    analyze_build();
+	    split = analyze_propagate();
+	} while (split >= 0);
+    }
+
+    // Final successors of every reachable block
+    succ.resize(cfg.size());
+    trips.assign(cfg.size(), 0);
+    exits.resize(cfg.size());
+    for (i = 0; i < cfg.size(); i++) {
+	if (!cfg[i].reachable) {
+	    continue;
+	}
+	analyze_block(i, &cfg[i].in, &exits[i]);
+	trips[i] = exits[i].trips;
+	for (j = 0; j < (unsigned int)exits[i].count; j++) {
+	    succ[i].push_back(exits[i].succ[j]);
+	}
+    }
+
+    if (n > 0) {
+	analyze_loops(succ, trips, loop_array);
+    }
+
+    // Instruction mix, invalid opcodes and unreachable code
+    memset(static_mix, 0, sizeof(static_mix));
+    memset(reachable_mix, 0, sizeof(reachable_mix));
+    static_cycles = 0;
+    unreachable = 0;
+    for (i = 0; i < cfg.size(); i++) {
+	end = cfg[i].first + cfg[i].length;
+	for (j = cfg[i].first; j < end; j++) {
+	    name = get_inst_name(code[j].opcode);
+	    if (name >= 0) {
+		static_mix[name]++;
+		if (cfg[i].reachable) {
+		    reachable_mix[name]++;
+		}
+	    }
+	    else if (!perf_opcode(code[j].opcode)) {
+		obj.clear();
+		obj["address"] = j << 1;
+		obj["opcode"] = code[j].opcode;
+		obj["reachable"] = cfg[i].reachable ? true : false;
+		invalid_array.append(obj);
+	    }
+	}
+
+	if (cfg[i].reachable) {
+	    static_cycles += cfg[i].cycles;
+	}
+	else {
+	    unreachable += cfg[i].length;
+	    if ((i > 0) && !cfg[i - 1].reachable) {
+		unreachable_array[unreachable_array.size() - 1]["end"] = (end - 1) << 1;
+	    }
+	    else {
+		obj.clear();
+		obj["start"] = cfg[i].start;
+		obj["end"] = (end - 1) << 1;
+		unreachable_array.append(obj);
+	    }
+	}
+    }
+
+    // Blocks, indirect jumps, faults and exits from the program
+    resolved = 0;
+    for (i = 0; i < cfg.size(); i++) {
+	end = cfg[i].first + cfg[i].length - 1;
+
+	succ_array = Json::Value(Json::arrayValue);
+	for (j = 0; j < succ[i].size(); j++) {
+	    succ_array.append(cfg[succ[i][j]].start);
+	}
+
+	obj.clear();
+	obj["start"] = cfg[i].start;
+	obj["end"] = end << 1;
+	obj["instructions"] = cfg[i].length;
+	obj["cycles"] = (Json::UInt64)cfg[i].cycles;
+	obj["reachable"] = cfg[i].reachable ? true : false;
+	obj["loop_depth"] = cfg[i].loop_depth;
+	obj["successors"] = succ_array;
+	block_array.append(obj);
+
+	if (!cfg[i].reachable) {
+	    continue;
+	}
+
+	if (exits[i].fault >= 0) {
+	    obj.clear();
+	    obj["address"] = (cfg[i].first + exits[i].fault) << 1;
+	    obj["reason"] = exits[i].reason;
+	    fault_array.append(obj);
+	}
+	else if ((code[end].opcode == 0x0C) || (code[end].opcode == 0x13)) {
+	    obj.clear();
+	    obj["address"] = end << 1;
+	    obj["kind"] = (code[end].opcode == 0x0C) ? "jr" : "jalr";
+	    if (!exits[i].indirect) {
+		obj["target"] = exits[i].target;
+		resolved++;
+	    }
+	    indirect_array.append(obj);
+	}
+
+	if (exits[i].outside >= 0) {
+	    obj.clear();
+	    obj["address"] = end << 1;
+	    obj["target"] = exits[i].outside;
+	    obj["wraps_to_zero"] = (exits[i].outside & 0x0001) ? false : true;
+	    outside_array.append(obj);
+	}
+    }
+
+    // Follow the single path from address 0 while there is one
+    memset(predict_mix, 0, sizeof(predict_mix));
+    predict_insts = 0;
+    predict_cycles = 0;
+    complete = 0;
+    stop = "empty program";
+    index = (n > 0) ? 0 : -1;
+    visited.assign(cfg.size(), 0);
+    while (index >= 0) {
+	if (visited[index]) {
+	    stop = "endless loop";
+	    break;
+	}
+	visited[index] = 1;
+
+	times = trips[index] ? trips[index] : 1;
+	end = cfg[index].first + ((exits[index].fault >= 0) ? exits[index].fault : cfg[index].length);
+	for (j = cfg[index].first; j < end; j++) {
+	    name = get_inst_name(code[j].opcode);
+	    if (name == N_HALT) {
+		predict_mix[name] = 1;
+		predict_insts += 1;
+		predict_cycles += 1;
+	    }
+	    else if (name >= 0) {
+		predict_mix[name] += times;
+		predict_insts += times;
+		predict_cycles += times * analyze_latency(&code[j]);
+	    }
+	}
+
+	end = cfg[index].first + cfg[index].length - 1;
+	if ((exits[index].fault >= 0) || (code[end].opcode == 0x0D)) {
+	    complete = 1;
+	    stop = (exits[index].fault >= 0) ? "fault" : "halt";
+	    break;
+	}
+	if (exits[index].call) {
+	    stop = "call";
+	    break;
+	}
+	if (exits[index].indirect) {
+	    stop = "indirect jump";
+	    break;
+	}
+	if (exits[index].count != 1) {
+	    stop = (exits[index].outside >= 0) ? "leaves the program" : "branch on a varying register";
+	    break;
+	}
+	predict_mix[N_ADD] += exits[index].wrap[0];
+	predict_insts += exits[index].wrap[0];
+	predict_cycles += exits[index].wrap[0] * (unsigned long long)latency_vals[ADD];
+	index = exits[index].succ[0];
+    }
+    stop_pc = (!complete && (index >= 0)) ? (int)((cfg[index].first + cfg[index].length - 1) << 1) : -1;
+
+    // Loops and calls on constants only have one path when walked
+    if (!complete && (n > 0) && analyze_walk(walk_mix, &walk_insts, &walk_cycles, &walk_stop, &walk_pc)) {
+	memcpy(predict_mix, walk_mix, sizeof(predict_mix));
+	predict_insts = walk_insts;
+	predict_cycles = walk_cycles;
+	stop = walk_stop;
+	complete = 1;
+	stop_pc = -1;
+    }
+
+    for (i = 0; i < 22; i++) {
+	static_obj[stat_names[i]] = (Json::UInt64)static_mix[i];
+	reachable_obj[stat_names[i]] = (Json::UInt64)reachable_mix[i];
+	predict_stats[stat_names[i]] = (Json::UInt64)predict_mix[i];
+    }
+
+    predict_obj["complete"] = complete ? true : false;
+    predict_obj["end"] = stop;
+    if (stop_pc >= 0) {
+	predict_obj["stops_at"] = stop_pc;
+    }
+    predict_obj["instructions"] = (Json::UInt64)predict_insts;
+    predict_obj["cycles"] = (Json::UInt64)predict_cycles;
+    predict_obj["stats"] = predict_stats;
+
+    root["program_size"] = n;
+    root["static_mix"] = static_obj;
+    root["reachable_mix"] = reachable_obj;
+    root["static_cycles"] = (Json::UInt64)static_cycles;
+    root["blocks"] = block_array;
+    root["loops"] = loop_array;
+    root["unreachable"] = unreachable_array;
+    root["invalid_opcodes"] = invalid_array;
+    root["indirect_jumps"] = indirect_array;
+    root["faults"] = fault_array;
+    root["leaves_program"] = outside_array;
+    root["prediction"] = predict_obj;
+
+    outfile.open(filename);
+    outfile << styledWriter.write(root);
+    outfile.close();
+
+    // Summary
+    cout << "Analysis: " << n << " instructions in " << cfg.size() << " blocks, " << loop_array.size() << " loops" << endl;
+    cout << "  Unreachable instructions\t" << unreachable << endl;
+    cout << "  Invalid opcodes\t\t" << invalid_array.size() << endl;
+    cout << "  Indirect jumps\t\t" << indirect_array.size() << " (" << resolved << " resolved)" << endl;
+    cout << "  Faults\t\t\t" << fault_array.size() << endl;
+    if (complete) {
+	cout << "  Prediction\t\t\t" << predict_insts << " instructions, " << predict_cycles << " cycles (" << stop << ")" << endl;
+    }
+    else {
+	cout << "  Prediction\t\t\tnone, " << stop << endl;
+    }
+
+    return;
+}
@@ -0,0 +1,454 @@
+// //////////////////////////////////////////////////////////////////
+// File: xblock.cpp
+// Description: Splits instruction memory into basic blocks the first
+//              time execution reaches them. A block ends after a
+//              branch, jump, HALT or MAX_BLOCK_LENGTH instructions and
+//              keeps its instructions decoded along with how many of
+//              each it holds, so the fast engine neither decodes nor
+//              counts one instruction at a time. Blocks only count
+//              how often they ran, block_flush() turns that into the
+//              per-instruction counters.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xblock.h"
+
+using namespace std;
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread unsigned char inst_memory[MEM_SIZE];
+extern __thread unsigned long long clock_cycles[22];
+// //////////////////////////////////////////
+
+thread_local vector<struct xblock> blocks;	// Blocks decoded so far
+thread_local vector<struct xop> block_ops;	// Instructions of every block
+thread_local vector<struct xmix> block_mix;	// Instruction mix of every block
+__thread int block_index[MEM_SIZE/2];	// Block starting at each address, or -1
+
+// /////////////////////////////////////////////////////////////////
+// Description: Forgets every decoded block, called whenever
+//              instruction memory is loaded. Only the entries of
+//              block_index that were set are cleared once the whole
+//              table has been cleared the first time.
+// /////////////////////////////////////////////////////////////////
+void block_reset() {
+    static __thread int cleared = 0;	// block_index was cleared once
+    unsigned int i;				// Count variable
+
+    if (!cleared) {
+	memset(block_index, 0xFF, sizeof(block_index));
+	cleared = 1;
+    }
+    for (i = 0; i < blocks.size(); i++) {
+	block_index[blocks[i].start >> 1] = -1;
+    }
+
+    blocks.clear();
+    block_ops.clear();
+    block_mix.clear();
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Even address of an instruction
+// Outputs: The instruction, decoded
+// /////////////////////////////////////////////////////////////////
+void block_op(unsigned short int addr, struct xop * op) {
+    unsigned short int inst;		// 16-Bit value of instruction
+    unsigned short int opcode;		// Opcode Value
+    short int imm8;			// I-Type immediate
+
+    inst = (unsigned short int)(inst_memory[addr] << 8) | (unsigned short int)(inst_memory[addr + 1]);
+    get_opcode(inst, &opcode);
+    imm8 = inst & 0x00FF;
+
+    op->opcode = opcode;
+    op->rd = (inst >> 8) & 0x0007;
+    op->rs = (inst >> 5) & 0x0007;
+    op->rt = (inst >> 2) & 0x0007;
+    op->imm = 0;
+    op->target = 0;
+
+    switch (opcode) {
+	case (0x10):
+	    op->imm = 0x00FF & imm8;
+	    break;
+	case (0x11):
+	    op->imm = (imm8 >> 7) ? (short int)(0xFF00 | imm8) : (short int)(imm8 & 0x00FF);
+	    break;
+	case (0x12):
+	    op->imm = imm8;
+	    break;
+	case (0x14):
+	case (0x15):
+	case (0x16):
+	case (0x17):
+	    op->target = 0x01FF & (imm8 << 1);
+	    break;
+	case (0x18):
+	    op->target = (unsigned short int)(addr & 0xF000) | (unsigned short int)((inst & 0x07FF) << 1);
+	    break;
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: One 5-bit opcode
+// Outputs: Non-zero if the instruction ends a block
+// /////////////////////////////////////////////////////////////////
+int block_ends(unsigned short int opcode) {
+
+    return (opcode == 0x0C) || (opcode == 0x0D) || ((opcode >= 0x13) && (opcode <= 0x18));
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Decoded instructions of a self loop and their number
+// Outputs: Non-zero if the loop fills or copies memory
+// Description: The body is induction steps (ADD/SUB of a register to
+//              itself by a loop-invariant register) and either one SW
+//              of a loop-invariant register, as memset does, or one LW
+//              followed by one SW of the loaded register, as memcpy
+//              does. LW and SW addresses and the tested register are
+//              stepped registers. Whether the addresses move by one
+//              word per trip is only known at run time.
+// /////////////////////////////////////////////////////////////////
+static int block_bulk_form(const struct xop * ops, unsigned int length) {
+    const struct xop * branch;		// Terminating branch
+    const struct xop * load;		// LW of the body, if any
+    const struct xop * store;		// SW of the body
+    int stepped;			// Registers the steps write
+    int loaded;				// Register LW writes
+    unsigned int i;			// Count variable
+
+    branch = &ops[length - 1];
+    load = 0;
+    store = 0;
+    stepped = 0;
+    for (i = 0; i + 1 < length; i++) {
+	switch (ops[i].opcode) {
+	    case (0x00):
+	    case (0x01):
+		if (ops[i].rd != ops[i].rs) {
+		    return 0;
+		}
+		stepped |= 1 << ops[i].rd;
+		break;
+	    case (0x08):
+		if (load || store) {
+		    return 0;
+		}
+		load = &ops[i];
+		break;
+	    case (0x09):
+		if (store) {
+		    return 0;
+		}
+		store = &ops[i];
+		break;
+	    default:
+		return 0;
+	}
+    }
+    if (!store || !(stepped & (1 << store->rs)) || !(stepped & (1 << branch->rd))) {
+	return 0;
+    }
+
+    if (load) {
+	loaded = 1 << load->rd;
+	if ((store->rt != load->rd) || (stepped & loaded) || !(stepped & (1 << load->rs))) {
+	    return 0;
+	}
+    }
+    else {
+	loaded = 0;
+	if (stepped & (1 << store->rt)) {
+	    return 0;
+	}
+    }
+
+    // Steps must not change within the loop
+    for (i = 0; i + 1 < length; i++) {
+	if ((ops[i].opcode <= 0x01) && ((stepped | loaded) & (1 << ops[i].rt))) {
+	    return 0;
+	}
+    }
+
+    return 1;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Decoded instructions of a block, their number and the
+//         block's address
+// Outputs: Loop_Kind of the block
+// Description: A self loop can be run without going back through the
+//              engine when its body only reads and writes registers.
+//              It is an induction loop when every body instruction
+//              adds a loop-invariant register to its own destination
+//              and the branch tests one of those registers, which
+//              makes its trip count solvable up front. Loops that fill
+//              or copy memory are LOOP_BULK.
+// /////////////////////////////////////////////////////////////////
+int block_loop_kind(const struct xop * ops, unsigned int length, unsigned short int start) {
+    const struct xop * op;		// Instruction looked at
+    const struct xop * branch;		// Terminating branch
+    int written;			// Registers written by the body
+    int induction;			// Body fits the induction form
+    unsigned int i;			// Count variable
+
+    branch = &ops[length - 1];
+    if ((branch->opcode < 0x14) || (branch->opcode > 0x17) || (branch->target != start)) {
+	return LOOP_NONE;
+    }
+
+    written = 0;
+    induction = 1;
+    for (i = 0; i + 1 < length; i++) {
+	op = &ops[i];
+	if ((op->opcode == 0x08) || (op->opcode == 0x09)) {
+	    return block_bulk_form(ops, length) ? LOOP_BULK : LOOP_NONE;
+	}
+	if ((op->opcode > 0x07) && ((op->opcode < 0x10) || (op->opcode > 0x12))) {
+	    return LOOP_NONE;
+	}
+	if ((op->opcode > 0x01) || (op->rd != op->rs)) {
+	    induction = 0;
+	}
+	written |= 1 << op->rd;
+    }
+
+    // Steps must not change within the loop
+    for (i = 0; induction && (i + 1 < length); i++) {
+	if (written & (1 << ops[i].rt)) {
+	    induction = 0;
+	}
+    }
+
+    if (induction && (written & (1 << branch->rd))) {
+	return LOOP_INDUCTION;
+    }
+
+    return LOOP_ITERATE;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Decoded instructions of an induction or bulk loop block,
+//         their number, the registers on entry and the per-register
+//         step, filled in
+// Outputs: Times the block runs before the branch falls through, or 0
+//          if the loop does not exit in a way solved here
+// Description: After the first trip the tested register c goes up by
+//              the same step d every trip, so the exit is where
+//              c1 + k*d first fails the branch condition, wrapping
+//              at 16 bits as the registers do.
+// /////////////////////////////////////////////////////////////////
+unsigned long long block_trips(const struct xop * op, unsigned int length, const short int * regs, unsigned short int * step) {
+    const struct xop * branch = op + length - 1;
+    short int c1;			// Tested register after one trip
+    short int d;			// Step of the tested register
+    unsigned int inverse;		// Inverse of the odd part of d
+    unsigned int low;			// Lowest set bit of d
+    unsigned int need;			// Total step needed to reach zero
+    unsigned int i;			// Count variable
+
+    memset(step, 0, 8 * sizeof(unsigned short int));
+    for (i = 0; i + 1 < length; i++) {
+	if (op[i].opcode == 0x00) {
+	    step[op[i].rd] += regs[op[i].rt];
+	}
+	else if (op[i].opcode == 0x01) {
+	    step[op[i].rd] -= regs[op[i].rt];
+	}
+    }
+
+    d = step[branch->rd];
+    c1 = regs[branch->rd] + d;
+
+    switch (branch->opcode) {
+	case (0x14):
+	    if (c1 <= 0) {
+		return 1;
+	    }
+	    if (d >= 0) {
+		return 0;
+	    }
+	    return 1 + (c1 - d - 1) / -d;
+	case (0x15):
+	    if (c1 >= 0) {
+		return 1;
+	    }
+	    if (d <= 0) {
+		return 0;
+	    }
+	    return 1 + (d - c1 - 1) / d;
+	case (0x16):
+	    if (c1 == 0) {
+		return 1;
+	    }
+	    if (d == 0) {
+		return 0;
+	    }
+	    // Solve k*d = -c1 (mod 2^16), d's odd part has an inverse
+	    low = (unsigned short int)d & -(unsigned short int)d;
+	    need = (unsigned short int)-c1;
+	    if (need % low) {
+		return 0;
+	    }
+	    inverse = (unsigned short int)d / low;
+	    for (i = 0; i < 4; i++) {
+		inverse *= 2 - ((unsigned short int)d / low) * inverse;
+	    }
+	    return 1 + (((need / low) * inverse) & (65536 / low - 1));
+	default:
+	    if (c1 != 0) {
+		return 1;
+	    }
+	    return (d == 0) ? 0 : 2;
+    }
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Even address of the block's first instruction
+// Outputs: Index of the new block in blocks
+// /////////////////////////////////////////////////////////////////
+int block_decode(unsigned short int pc) {
+    struct xblock b;			// Block being built
+    struct xop op;			// Instruction being decoded
+    struct xmix mix;			// Mix entry being added
+    unsigned int counts[22];		// Instructions per Instruction_Name
+    unsigned short int addr;		// Address of the instruction
+    unsigned short int opcode;		// Opcode Value
+    int name;				// Instruction_Name of the opcode
+    int reads;				// Registers the instruction reads
+    int i;				// Count variable
+
+    memset(counts, 0, sizeof(counts));
+
+    b.start = pc;
+    b.length = 0;
+    b.first = block_ops.size();
+    b.flags = 0;
+    b.live_in = 0;
+    b.live_out = 0;
+
+    addr = pc;
+    do {
+	block_op(addr, &op);
+	opcode = op.opcode;
+
+	switch (opcode) {
+	    case (0x04):
+	    case (0x06):
+		b.flags |= BLOCK_CAN_FAULT;
+		break;
+	    case (0x08):
+	    case (0x09):
+		b.flags |= BLOCK_CAN_FAULT | BLOCK_HAS_MEM;
+		break;
+	}
+
+	// Registers read before this block wrote them are live in
+	switch (opcode) {
+	    case (0x10):
+	    case (0x11):
+	    case (0x0D):
+	    case (0x18):
+		reads = 0;
+		break;
+	    case (0x12):
+	    case (0x14):
+	    case (0x15):
+	    case (0x16):
+	    case (0x17):
+		reads = 1 << op.rd;
+		break;
+	    case (0x08):
+	    case (0x0C):
+	    case (0x0E):
+		reads = 1 << op.rs;
+		break;
+	    case (0x13):
+		// JALR writes RD before reading RS
+		b.live_out |= 1 << op.rd;
+		reads = 1 << op.rs;
+		break;
+	    default:
+		reads = (1 << op.rs) | (1 << op.rt);
+		break;
+	}
+	b.live_in |= reads & ~b.live_out;
+	if ((opcode <= 0x08) || ((opcode >= 0x10) && (opcode <= 0x12))) {
+	    b.live_out |= 1 << op.rd;
+	}
+
+	// HALT sets its counter rather than adding to it
+	name = get_inst_name(opcode);
+	if (name < 0) {
+	    b.flags |= BLOCK_HAS_IO;
+	}
+	else if (name == N_PUT) {
+	    b.flags |= BLOCK_HAS_IO;
+	    counts[name]++;
+	}
+	else if (name != N_HALT) {
+	    counts[name]++;
+	}
+
+	block_ops.push_back(op);
+	b.length++;
+	addr += 2;
+    } while (!block_ends(opcode) && (b.length < MAX_BLOCK_LENGTH) && (addr != 0));
+
+    b.next = addr;
+
+    if (!(b.flags & (BLOCK_HAS_MEM | BLOCK_HAS_IO)) && (opcode != 0x0D)) {
+	b.flags |= BLOCK_PURE;
+    }
+    b.memo = 1;
+    b.memo_tries = 0;
+    b.memo_hits = 0;
+    b.runs = 0;
+
+    // Instruction mix
+    b.mix_first = block_mix.size();
+    for (i = 0; i < 22; i++) {
+	if (counts[i]) {
+	    mix.name = i;
+	    mix.count = counts[i];
+	    block_mix.push_back(mix);
+	}
+    }
+    b.mix_length = block_mix.size() - b.mix_first;
+
+    b.loop = block_loop_kind(&block_ops[b.first], b.length, b.start);
+
+    blocks.push_back(b);
+    block_index[pc >> 1] = blocks.size() - 1;
+
+    return blocks.size() - 1;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Adds the instruction mix of every block, times the runs
+//              it completed, to clock_cycles. Called before anything
+//              reads clock_cycles.
+// /////////////////////////////////////////////////////////////////
+void block_flush() {
+    const struct xmix * mix;		// Mix of the block
+    unsigned int i, j;			// Count variables
+
+    for (i = 0; i < blocks.size(); i++) {
+	if (blocks[i].runs) {
+	    mix = &block_mix[blocks[i].mix_first];
+	    for (j = 0; j < blocks[i].mix_length; j++) {
+		clock_cycles[mix[j].name] += blocks[i].runs * mix[j].count;
+	    }
+	    blocks[i].runs = 0;
+	}
+    }
+
+    return;
+}
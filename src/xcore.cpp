@@ -0,0 +1,591 @@
+// //////////////////////////////////////////////////////////////////
+// File: xcore.cpp
+// Description: Simulator state and the steps of a run shared by the
+//              command line, the --serve daemon and libxsim: loading
+//              a program and configuration, resetting, run limits and
+//              building the output stats
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xcore.h"
+#include "xengine.h"
+#include "xlive.h"
+#include "xinterval.h"
+#include "xmem.h"
+#include "xperf.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Instructions between checks of the --max-seconds limit
+#define CLOCK_CHECK_PERIOD 65536
+// Room for the output file formatted by format_output
+#define OUTPUT_BUFFER_SIZE 2048
+
+// Local Procedures
+void hex2bin (string line, unsigned char * instruction);
+char bin2hex (short int onebyte);
+
+// ///////////////////////////////////////////////////////
+
+// ///////////////////////////////////////////////////////
+// Global Variables
+// ///////////////////////////////////////////////////////
+__thread int latency_vals[8];			// Latency values of arithmetic instructions
+__thread unsigned long long clock_cycles[22];	// Number of cycles per instruction
+__thread unsigned char inst_memory[MEM_SIZE];	// Instruction Memory
+__thread short int reg_file[8];			// Register File
+__thread unsigned short int program_counter;	// Program Counter
+__thread int program_size;				// Bytes of instruction memory loaded
+__thread int trace_enabled = 1;			// Print the instruction trace
+__thread long long live_left = -1;			// Instructions until live update
+__thread long long interval_left = -1;		// Instructions until interval line
+__thread long long max_instructions = 0;		// Instruction limit, 0 for none
+__thread double max_seconds = 0;			// Wall time limit, 0 for none
+__thread long long budget_left = -1;		// Instructions until the limit
+__thread long long clock_left = -1;			// Instructions until the time check
+__thread struct timespec run_start;			// When execution began
+__thread int limit_hit = LIMIT_NONE;		// Run_Limit that stopped execution
+// ///////////////////////////////////////////////////////
+
+void hex2bin (string line, unsigned char * instruction) {
+    int i;			// Counting variable
+    unsigned short int temp;	// temporary value
+
+    // Initialize values
+    *instruction = 0;
+    temp = 0;
+
+    i = 0;
+
+    // Loop while line is a character or digit
+    while (isalnum(line[i])) {
+	// Shift temp
+	temp = temp << 4;
+	
+	// Convert hex to number
+	if ((line[i] >= 'A') && (line[i] <= 'F')) {
+	    temp=(temp|((line[i]-'A'+10)));
+	}
+	else if ((line[i] >= 'a') && (line[i] <= 'f')) {
+	    temp=(temp|((line[i]-'a'+10)));
+	}
+	else {
+	    temp=(temp|((line[i]-'0')));
+	}
+
+	i++;
+    }
+
+    // Copy temp
+    memcpy(instruction, &temp, sizeof(char));
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Program, one hex instruction per line, '#' for comments
+// Outputs: Bytes of instruction memory loaded
+// Description: Loads the program at address 0. Whatever a previous
+//              program left past its end is cleared.
+// /////////////////////////////////////////////////////////////////
+int load_program(istream & in) {
+    string line;		// String for instruction line
+    int i;			// Count variable
+
+    i = 0;
+
+    while (getline(in, line) && (i < MEM_SIZE)) {
+	// Ignore Comments
+	if (line[0] != '#') {
+	    // Convert hex to binary representation
+	    hex2bin(line.substr(0,2), &inst_memory[i++]);
+	    hex2bin(line.substr(2,2), &inst_memory[i]);
+	    i++;
+	}
+    }
+
+    if (program_size > i) {
+	memset(&inst_memory[i], 0, program_size - i);
+    }
+    program_size = i;
+
+    return i;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Clears the counters, registers and data memory and
+//              starts execution at address 0
+// /////////////////////////////////////////////////////////////////
+void reset_state() {
+
+    mem_reset();
+    memset(clock_cycles, 0, sizeof(clock_cycles));
+    memset(reg_file, 0, sizeof(reg_file));
+    program_counter = 0;
+    limit_hit = LIMIT_NONE;
+    perf_reset();
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Schedules the periodic work of a run about to start
+// /////////////////////////////////////////////////////////////////
+void periodic_start() {
+
+    live_left = live_enabled ? LIVE_PERIOD : -1;
+    interval_left = (interval_length > 0) ? interval_length : -1;
+    budget_left = (max_instructions > 0) ? max_instructions : -1;
+    clock_left = (max_seconds > 0) ? CLOCK_CHECK_PERIOD : -1;
+    clock_gettime(CLOCK_MONOTONIC, &run_start);
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Outputs: Instructions until the nearest periodic work, -1 for none
+// /////////////////////////////////////////////////////////////////
+long long periodic_next() {
+    long long span = -1;
+
+    if ((live_left > 0) && ((span < 0) || (live_left < span))) {
+	span = live_left;
+    }
+    if ((interval_left > 0) && ((span < 0) || (interval_left < span))) {
+	span = interval_left;
+    }
+    if ((budget_left > 0) && ((span < 0) || (budget_left < span))) {
+	span = budget_left;
+    }
+    if ((clock_left > 0) && ((span < 0) || (clock_left < span))) {
+	span = clock_left;
+    }
+
+    return span;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Instructions executed since the previous call
+// Outputs: Non-zero when a run limit was reached
+// Description: Runs every periodic task that has come due
+// /////////////////////////////////////////////////////////////////
+int periodic_events(long long span) {
+    struct timespec now;	// Current time for the time limit
+    double elapsed;		// Seconds since execution began
+
+    if (live_left > 0) {
+	live_left -= span;
+	if (live_left == 0) {
+	    live_publish(LIVE_RUNNING);
+	    live_left = LIVE_PERIOD;
+	}
+    }
+
+    if (interval_left > 0) {
+	interval_left -= span;
+	if (interval_left == 0) {
+	    interval_emit();
+	    interval_left = interval_length;
+	}
+    }
+
+    if (budget_left > 0) {
+	budget_left -= span;
+	if (budget_left == 0) {
+	    limit_hit = LIMIT_INSTRUCTIONS;
+	    return 1;
+	}
+    }
+
+    if (clock_left > 0) {
+	clock_left -= span;
+	if (clock_left == 0) {
+	    clock_gettime(CLOCK_MONOTONIC, &now);
+	    elapsed = (now.tv_sec - run_start.tv_sec) + (now.tv_nsec - run_start.tv_nsec) / 1e9;
+	    if (elapsed >= max_seconds) {
+		limit_hit = LIMIT_SECONDS;
+		return 1;
+	    }
+	    clock_left = CLOCK_CHECK_PERIOD;
+	}
+    }
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Message explaining why execution stopped
+// Description: Prints the message, the program counter and registers
+// /////////////////////////////////////////////////////////////////
+void dump_state(const char * reason) {
+    unsigned long long inst_count;
+    char line[64];
+    int i;
+
+    inst_count = 0;
+    for (i = 0; i < 22; i++) {
+	inst_count += clock_cycles[i];
+    }
+
+    *guest_out << reason << endl;
+    snprintf(line, sizeof(line), "  PC: 0x%04x  Instructions: %llu\n", program_counter, inst_count);
+    *guest_out << line;
+    for (i = 0; i < 8; i++) {
+	*guest_out << "  R" << i << ": " << reg_file[i];
+    }
+    *guest_out << "\n";
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// This function is for debugging purposes
+// /////////////////////////////////////////////////////////////////
+void read_data_mem() {
+    ifstream mem_file;
+    string line1, line2;
+    unsigned char temp1, temp2;
+    int i;
+
+    mem_file.open("data_mem.txt");
+
+    if (!mem_file.is_open()) {
+	cout << "File Does Not Exist" << endl;
+    }
+
+    i = 0;
+
+    while (mem_file >> line1) {
+	mem_file >> line2;
+	temp1 = 0;
+	temp2 = 0;
+
+	hex2bin(line1, &temp1);
+	hex2bin(line2, &temp2);
+
+	mem_write_byte(0, i++, temp1);
+	mem_write_byte(0, i++, temp2);
+    }
+
+    mem_file.close();
+
+    return;
+}
+
+// Convert a binary value back to hex
+char bin2hex (short int onebyte) {
+    char hex_val;		// hex value
+
+    // Convert
+    switch (onebyte) {
+	case 0:
+	    hex_val = '0';
+	    break;
+	case 1:
+	    hex_val = '1';
+	    break;
+	case 2:
+	    hex_val = '2';
+	    break;
+	case 3:
+	    hex_val = '3';
+	    break;
+	case 4:
+	    hex_val = '4';
+	    break;
+	case 5:
+	    hex_val = '5';
+	    break;
+	case 6:
+	    hex_val = '6';
+	    break;
+	case 7:
+	    hex_val = '7';
+	    break;
+	case 8:
+	    hex_val = '8';
+	    break;
+	case 9:
+	    hex_val = '9';
+	    break;
+	case 10:
+	    hex_val = 'A';
+	    break;
+	case 11:
+	    hex_val = 'B';
+	    break;
+	case 12:
+	    hex_val = 'C';
+	    break;
+	case 13:
+	    hex_val = 'D';
+	    break;
+	case 14:
+	    hex_val = 'E';
+	    break;
+	case 15:
+	    hex_val = 'F';
+	    break;
+	default:
+	    break;
+    }
+
+    return hex_val;
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// This function is for debugging purposes
+// ///////////////////////////////////////////////////////////////////////
+void write_data_mem() {
+    ofstream outfile;
+    int i;
+    int j;
+    short int temp;
+    char line[2];
+
+    outfile.open("data_mem.txt", ios::trunc);
+
+    j = 0;
+
+    if (outfile.is_open()) {
+	for (i = 0; i < (MEM_SIZE/2); i++) {
+	    temp = mem_read_byte(0, i);
+	    outfile << bin2hex(((temp >> 4) & 0x000F)) << bin2hex(((temp) & 0x000F)) << "\n";
+	    temp = mem_read_byte(0, ++i);
+	    outfile << bin2hex(((temp >> 4) & 0x000F)) << bin2hex(((temp) & 0x000F)) << "\n";
+	}
+    }
+
+    outfile.close();
+}
+
+// Read the configuration file
+void read_config(char * filename) {
+    Json::Value root;		// JSON variable
+    ifstream test(filename);	// Input file
+
+    // Copy configuration to root
+    test >> root;
+
+    apply_config(root);
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Parsed configuration file
+// Description: Sets the latencies it lists, 1 for the others
+// /////////////////////////////////////////////////////////////////
+void apply_config(const Json::Value & root) {
+
+    // Pull out values
+    latency_vals[ADD] = root.get("add", 1).asInt();
+    latency_vals[SUB] = root.get("sub", 1).asInt();
+    latency_vals[AND] = root.get("and", 1).asInt();
+    latency_vals[NOR] = root.get("nor", 1).asInt();
+    latency_vals[DIV] = root.get("div", 1).asInt();
+    latency_vals[MUL] = root.get("mul", 1).asInt();
+    latency_vals[MOD] = root.get("mod", 1).asInt();
+    latency_vals[EXP] = root.get("exp", 1).asInt();
+
+#ifdef DEBUG
+
+    cout << "Add: " << latency_vals[ADD] << endl;
+    cout << "Sub: " << latency_vals[SUB] << endl;
+    cout << "And: " << latency_vals[AND] << endl;
+    cout << "NOR: " << latency_vals[NOR] << endl;
+    cout << "DIV: " << latency_vals[DIV] << endl;
+    cout << "MUL: " << latency_vals[MUL] << endl;
+    cout << "Mod: " << latency_vals[MOD] << endl;
+    cout << "EXP: " << latency_vals[EXP] << endl;
+
+#endif
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Output file name
+// Description: Formatted without building a Json::Value unless the
+//              critical path analysis or --perf-isa regions add their
+//              entries
+// /////////////////////////////////////////////////////////////////
+void write_output (char * filename) {
+    ofstream outfile;				// Output file
+    Json::Value array;				// Output stats
+    Json::StyledWriter styledWriter;
+    char buffer[OUTPUT_BUFFER_SIZE];		// Formatted output stats
+    int length;					// Bytes of it
+    int done;					// Bytes written
+    int count;
+    int fd;
+
+    if (!critpath_enabled && !perf_marked) {
+	length = format_output(buffer, sizeof(buffer));
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+	    return;
+	}
+	for (done = 0; done < length; done += count) {
+	    count = write(fd, buffer + done, length - done);
+	    if (count <= 0) {
+		break;
+	    }
+	}
+	close(fd);
+	return;
+    }
+
+    build_output(array);
+
+    // Open output
+    outfile.open(filename);
+
+    // Write stats
+    outfile << styledWriter.write(array);
+
+    // Close
+    outfile.close();
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Buffer and its size, OUTPUT_BUFFER_SIZE is enough
+// Outputs: Bytes formatted
+// Description: The output stats of the run that just ended, byte for
+//              byte as Json::StyledWriter writes build_output's object
+//              (keys sorted, three space indent), without allocating
+// /////////////////////////////////////////////////////////////////
+int format_output(char * buffer, int size) {
+    // Stats keys in StyledWriter's order: clock_cycles indices, then
+    // 22 for instructions and 23 for cycles
+    static const int stat_order[24] = {
+	N_ADD, N_AND, N_BN, N_BP, N_BX, N_BZ, 23, N_DIV, N_EXP, N_HALT, 22, N_J,
+	N_JAL, N_JR, N_LIS, N_LIZ, N_LUI, N_LW, N_MOD, N_MUL, N_NOR, N_PUT, N_SUB, N_SW
+    };
+    unsigned long long values[24];		// Counters and totals
+    int length;					// Bytes formatted so far
+    int i;
+
+    memcpy(values, clock_cycles, sizeof(clock_cycles));
+    count_totals(&values[22], &values[23]);
+
+    length = snprintf(buffer, size, "{\n   \"registers\" : [\n      {\n");
+    for (i = 0; i < 8; i++) {
+	length += snprintf(buffer + length, size - length, "         \"r%d\" : %d%s\n", i, reg_file[i], (i < 7) ? "," : "");
+    }
+
+    length += snprintf(buffer + length, size - length, "      }\n   ],\n   \"stats\" : [\n      {\n");
+    for (i = 0; i < 24; i++) {
+	length += snprintf(buffer + length, size - length, "         \"%s\" : %llu%s\n",
+		(stat_order[i] < 22) ? stat_names[stat_order[i]] : ((stat_order[i] == 22) ? "instructions" : "cycles"),
+		values[stat_order[i]], (i < 23) ? "," : "");
+    }
+    length += snprintf(buffer + length, size - length, "      }\n   ]\n}\n");
+
+    return length;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Outputs: Instructions executed and the cycles they took
+// /////////////////////////////////////////////////////////////////
+void count_totals(unsigned long long * inst_count, unsigned long long * num_cycles) {
+    int i;
+
+    *inst_count = 0;
+    *num_cycles = 0;
+    for (i = 0; i < 22; i++) {
+	*inst_count += clock_cycles[i];
+	if (i < 8) {
+	    *num_cycles += (clock_cycles[i] * latency_vals[i]);
+	}
+	else {
+	    *num_cycles += clock_cycles[i];
+	}
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Object to fill in
+// Description: Builds the output stats of the run that just ended
+// /////////////////////////////////////////////////////////////////
+void build_output(Json::Value & array) {
+    Json::Value stat_obj;			// JSON objects
+    Json::Value stat_array(Json::arrayValue);
+    Json::Value reg_obj;
+    Json::Value reg_array(Json::arrayValue);
+
+    unsigned long long inst_count;
+    unsigned long long num_cycles;
+
+    // Copy values in the register
+    reg_obj["r0"] = reg_file[0];
+    reg_obj["r1"] = reg_file[1];
+    reg_obj["r2"] = reg_file[2];
+    reg_obj["r3"] = reg_file[3];
+    reg_obj["r4"] = reg_file[4];
+    reg_obj["r5"] = reg_file[5];
+    reg_obj["r6"] = reg_file[6];
+    reg_obj["r7"] = reg_file[7];
+
+    // Append as array
+    reg_array.append(reg_obj);
+
+    // Copy instruction stats
+    stat_obj["add"] = (Json::UInt64)clock_cycles[N_ADD];
+    stat_obj["sub"] = (Json::UInt64)clock_cycles[N_SUB];
+    stat_obj["and"] = (Json::UInt64)clock_cycles[N_AND];
+    stat_obj["nor"] = (Json::UInt64)clock_cycles[N_NOR];
+    stat_obj["div"] = (Json::UInt64)clock_cycles[N_DIV];
+    stat_obj["mul"] = (Json::UInt64)clock_cycles[N_MUL];
+    stat_obj["mod"] = (Json::UInt64)clock_cycles[N_MOD];
+    stat_obj["exp"] = (Json::UInt64)clock_cycles[N_EXP];
+    stat_obj["lw"] = (Json::UInt64)clock_cycles[N_LW];
+    stat_obj["sw"] = (Json::UInt64)clock_cycles[N_SW];
+    stat_obj["liz"] = (Json::UInt64)clock_cycles[N_LIZ];
+    stat_obj["lis"] = (Json::UInt64)clock_cycles[N_LIS];
+    stat_obj["lui"] = (Json::UInt64)clock_cycles[N_LUI];
+    stat_obj["bp"] = (Json::UInt64)clock_cycles[N_BP];
+    stat_obj["bn"] = (Json::UInt64)clock_cycles[N_BN];
+    stat_obj["bx"] = (Json::UInt64)clock_cycles[N_BX];
+    stat_obj["bz"] = (Json::UInt64)clock_cycles[N_BZ];
+    stat_obj["jr"] = (Json::UInt64)clock_cycles[N_JR];
+    stat_obj["jal"] = (Json::UInt64)clock_cycles[N_JAL];
+    stat_obj["j"] = (Json::UInt64)clock_cycles[N_J];
+    stat_obj["halt"] = (Json::UInt64)clock_cycles[N_HALT];
+    stat_obj["put"] = (Json::UInt64)clock_cycles[N_PUT];
+
+    // Calculate number of cycles and instruction count
+    count_totals(&inst_count, &num_cycles);
+
+    // Copy counts
+    stat_obj["instructions"] = (Json::UInt64)inst_count;
+    stat_obj["cycles"] = (Json::UInt64)num_cycles;
+
+    // Append as array
+    stat_array.append(stat_obj);
+ 
+    // Combine as 1 object
+    array["registers"] = reg_array;  
+    array["stats"] = stat_array;  
+
+    // Add dataflow limit analysis
+    if (critpath_enabled) {
+	critpath_write(array, num_cycles);
+    }
+
+    // Stats of the regions the program marked
+    perf_write(array);
+
+#ifdef DEBUG
+
+    cout << endl << endl << array << endl;
+
+#endif
+
+    return;
+}
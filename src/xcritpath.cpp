@@ -0,0 +1,143 @@
+// //////////////////////////////////////////////////////////////////
+// File: xcritpath.cpp
+// Description: Tracks the earliest cycle at which every register and
+//              data memory word becomes available, assuming unlimited
+//              hardware and only true (read after write) dependences.
+//              Memory words are tracked per bank. The longest chain is the dataflow critical path, and the
+//              serial cycle count divided by it is the ideal ILP.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xcritpath.h"
+#include "xmem.h"
+#include <vector>
+
+using namespace std;
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread int latency_vals[8];
+// //////////////////////////////////////////
+
+__thread int critpath_enabled = 0;		// Analysis flag
+
+static __thread unsigned long long reg_ready[8];		// Cycle each register value is ready
+static thread_local vector<unsigned long long> mem_ready;	// Cycle each word of every bank is ready
+static __thread unsigned long long critical_path;		// Longest dependence chain so far
+
+// Return the larger of two ready times
+static inline unsigned long long later(unsigned long long a, unsigned long long b) {
+    return (a > b) ? a : b;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Clear all ready times before a new run
+// /////////////////////////////////////////////////////////////////
+void critpath_reset() {
+
+    memset(reg_ready, 0, sizeof(reg_ready));
+    mem_ready.assign((size_t)mem_banks * (MEM_SIZE / 2), 0);
+    critical_path = 0;
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: One 16-bit instruction that completed and, for LW/SW, the
+//         value its address register had before it ran
+// Description: Advances the ready time of the instruction's destination
+//              from the ready times of its sources. Constant work per
+//              instruction.
+// /////////////////////////////////////////////////////////////////
+void critpath_update(unsigned short int inst, unsigned short int mem_addr) {
+    unsigned short int op;		// Opcode
+    short int rd, rs, rt;		// Register numbers
+    unsigned int addr;			// Word index across the banks for memory operations
+    unsigned long long done;		// Cycle the result is available
+
+    get_opcode(inst, &op);
+
+    rd = (inst >> 8) & 0x0007;
+    rs = (inst >> 5) & 0x0007;
+    rt = (inst >> 2) & 0x0007;
+
+    switch (op) {
+	// Arithmetic uses the configured latency
+	case (0x00): case (0x01): case (0x02): case (0x03):
+	case (0x04): case (0x05): case (0x06): case (0x07):
+	    done = later(reg_ready[rs], reg_ready[rt]) + latency_vals[op];
+	    reg_ready[rd] = done;
+	    break;
+	// LW depends on the address and the stored word
+	case (0x08):
+	    addr = mem_bank(op, rd, rt) * (MEM_SIZE / 2) + (mem_addr >> 1);
+	    done = later(reg_ready[rs], mem_ready[addr]) + 1;
+	    reg_ready[rd] = done;
+	    break;
+	// SW makes the word ready once address and data are
+	case (0x09):
+	    addr = mem_bank(op, rd, rt) * (MEM_SIZE / 2) + (mem_addr >> 1);
+	    done = later(reg_ready[rs], reg_ready[rt]) + 1;
+	    mem_ready[addr] = done;
+	    break;
+	// Immediates have no inputs
+	case (0x10): case (0x11):
+	    done = 1;
+	    reg_ready[rd] = done;
+	    break;
+	// LUI keeps the low byte of rd
+	case (0x12):
+	    done = reg_ready[rd] + 1;
+	    reg_ready[rd] = done;
+	    break;
+	// Branches only consume rd
+	case (0x14): case (0x15): case (0x16): case (0x17):
+	    done = reg_ready[rd] + 1;
+	    break;
+	// JR and PUT only consume rs
+	case (0x0C): case (0x0E):
+	    done = reg_ready[rs] + 1;
+	    break;
+	// JALR consumes rs, the link value is a constant
+	case (0x13):
+	    done = reg_ready[rs] + 1;
+	    reg_ready[rd] = 1;
+	    break;
+	// J and HALT have no inputs
+	case (0x18): case (0x0D):
+	    done = 1;
+	    break;
+	default:
+	    return;
+    }
+
+    critical_path = later(critical_path, done);
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Output object and the serial cycle count of the run
+// Description: Adds the critical path length and ideal ILP to the
+//              output stats
+// /////////////////////////////////////////////////////////////////
+void critpath_write(Json::Value & array, unsigned long long serial_cycles) {
+    Json::Value cp_obj;
+    Json::Value cp_array(Json::arrayValue);
+
+    cp_obj["length"] = (Json::UInt64)critical_path;
+    cp_obj["cycles"] = (Json::UInt64)serial_cycles;
+    if (critical_path > 0) {
+	cp_obj["ilp"] = (double)serial_cycles / (double)critical_path;
+    }
+    else {
+	cp_obj["ilp"] = 0.0;
+    }
+
+    cp_array.append(cp_obj);
+
+    array["critical_path"] = cp_array;
+
+    return;
+}
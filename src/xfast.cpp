@@ -0,0 +1,627 @@
+// //////////////////////////////////////////////////////////////////
+// File: xfast.cpp
+// Description: Executes predecoded blocks instead of single
+//              instructions. Nothing is counted per instruction: a
+//              block only counts its completed runs, and block_flush()
+//              rebuilds clock_cycles from those before periodic work
+//              and at the end. Self loops whose body only touches
+//              registers are run in place, induction loops (counters
+//              stepped by loop-invariant registers) jump straight to
+//              their exit with the trip count solved in closed form,
+//              and loops that fill or copy data memory a word per trip
+//              are run as memset/memmove calls. With --memoize, blocks
+//              that only touch registers are looked up in the memo
+//              table (xmemo.cpp) before being run. Nothing is traced or
+//              instrumented, but stats, registers and memory come out
+//              exactly as they would from run_engine.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xfast.h"
+#include "xblock.h"
+#include "xmemo.h"
+#include "xengine.h"
+
+using namespace std;
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+// //////////////////////////////////////////
+
+__thread int fast_enabled = 0;	// Run with the fast engine
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Block and number of times it ran to completion
+// /////////////////////////////////////////////////////////////////
+static inline void fast_count(struct xblock * b, unsigned long long times) {
+
+    b->runs += times;
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Block and index of the instruction that faulted
+// Outputs: Instructions executed, including the faulting one
+// Description: Counts the instructions before the fault one by one,
+//              as the block did not complete, and stops execution the
+//              way the x_* handlers do
+// /////////////////////////////////////////////////////////////////
+static unsigned int fast_fault(const struct xblock * b, unsigned int index) {
+    const struct xop * op = &block_ops[b->first];
+    unsigned int i;
+    int name;
+
+    for (i = 0; i < index; i++) {
+	name = get_inst_name(op[i].opcode);
+	if (name >= 0) {
+	    clock_cycles[name] += 1;
+	}
+    }
+
+    program_counter = (unsigned short int)-1;
+
+    return index + 1;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Block and index of a --perf-isa instruction in it
+// Description: Brings clock_cycles up to the instruction, as it reads
+//              or copies them, and back to the block's completed runs
+// /////////////////////////////////////////////////////////////////
+static void fast_perf(struct xblock * b, unsigned int index) {
+    const struct xop * op = &block_ops[b->first];
+    unsigned short int addr;		// Address of the instruction
+    unsigned short int saved_pc;	// Set by the block so far
+    short int inst;			// 16-Bit value of instruction
+    unsigned int i;
+    int name;
+
+    block_flush();
+    for (i = 0; i < index; i++) {
+	name = get_inst_name(op[i].opcode);
+	if (name >= 0) {
+	    clock_cycles[name] += 1;
+	}
+    }
+
+    addr = b->start + 2 * index;
+    inst = (unsigned short int)(inst_memory[addr] << 8) | (unsigned short int)(inst_memory[addr + 1]);
+    saved_pc = program_counter;
+    program_counter = addr;
+    perf_execute(inst, op[index].opcode);
+    program_counter = saved_pc;
+
+    for (i = 0; i < index; i++) {
+	name = get_inst_name(op[i].opcode);
+	if (name >= 0) {
+	    clock_cycles[name] -= 1;
+	}
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Register-only instruction
+// Outputs: 0 if DIV or MOD would divide by zero, leaving registers as
+//          they were
+// /////////////////////////////////////////////////////////////////
+static inline int fast_alu(const struct xop * op) {
+
+    switch (op->opcode) {
+	case (0x00):
+	    reg_file[op->rd] = reg_file[op->rs] + reg_file[op->rt];
+	    break;
+	case (0x01):
+	    reg_file[op->rd] = reg_file[op->rs] - reg_file[op->rt];
+	    break;
+	case (0x02):
+	    reg_file[op->rd] = reg_file[op->rs] & reg_file[op->rt];
+	    break;
+	case (0x03):
+	    reg_file[op->rd] = ~(reg_file[op->rs] | reg_file[op->rt]);
+	    break;
+	case (0x04):
+	    if (reg_file[op->rt] == 0) {
+		return 0;
+	    }
+	    reg_file[op->rd] = reg_file[op->rs] / reg_file[op->rt];
+	    break;
+	case (0x05):
+	    reg_file[op->rd] = reg_file[op->rs] * reg_file[op->rt];
+	    break;
+	case (0x06):
+	    if (reg_file[op->rt] == 0) {
+		return 0;
+	    }
+	    reg_file[op->rd] = reg_file[op->rs] % reg_file[op->rt];
+	    break;
+	case (0x07):
+	    reg_file[op->rd] = exp_value(reg_file[op->rs], reg_file[op->rt]);
+	    break;
+	case (0x10):
+	case (0x11):
+	    reg_file[op->rd] = op->imm;
+	    break;
+	case (0x12):
+	    reg_file[op->rd] = (0xFF00 & (op->imm << 8)) | (0x00FF & reg_file[op->rd]);
+	    break;
+    }
+
+    return 1;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Conditional branch
+// Outputs: Non-zero if the branch is taken
+// /////////////////////////////////////////////////////////////////
+static inline int fast_taken(const struct xop * op) {
+
+    switch (op->opcode) {
+	case (0x14):
+	    return reg_file[op->rd] > 0;
+	case (0x15):
+	    return reg_file[op->rd] < 0;
+	case (0x16):
+	    return reg_file[op->rd] != 0;
+	default:
+	    return reg_file[op->rd] == 0;
+    }
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Block to run and the halting flag
+// Outputs: Instructions executed
+// Description: Runs the block once and sets program_counter
+// /////////////////////////////////////////////////////////////////
+static unsigned int fast_block(struct xblock * b, short int * halt_all) {
+    const struct xop * op;		// Instruction being executed
+    unsigned short int addr;		// Address used by LW/SW
+    unsigned int bank;			// Bank used by LW/SW
+    const char * fault;			// Why a LW/SW is not allowed
+    unsigned int i;			// Count variable
+
+    program_counter = b->next;
+
+    op = &block_ops[b->first];
+    for (i = 0; i < b->length; i++, op++) {
+	switch (op->opcode) {
+	    case (0x04):
+		if (!fast_alu(op)) {
+		    *guest_out << "Divide by 0 Error...Terminating\n";
+		    return fast_fault(b, i);
+		}
+		break;
+	    case (0x06):
+		if (!fast_alu(op)) {
+		    *guest_out << "Cannot MOD by 0...terminating\n";
+		    return fast_fault(b, i);
+		}
+		break;
+	    case (0x00):
+	    case (0x01):
+	    case (0x02):
+	    case (0x03):
+	    case (0x05):
+	    case (0x07):
+	    case (0x10):
+	    case (0x11):
+	    case (0x12):
+		fast_alu(op);
+		break;
+	    case (0x08):
+	    case (0x09):
+		addr = (unsigned short int)reg_file[op->rs];
+		bank = mem_bank(op->opcode, op->rd, op->rt);
+		fault = mem_check(bank, addr);
+		if (fault) {
+		    *guest_out << fault << endl;
+		    return fast_fault(b, i);
+		}
+		if (op->opcode == 0x08) {
+		    reg_file[op->rd] = mem_load(bank, addr);
+		}
+		else {
+		    mem_store(bank, addr, reg_file[op->rt]);
+		}
+		break;
+	    case (0x14):
+	    case (0x15):
+	    case (0x16):
+	    case (0x17):
+		program_counter = fast_taken(op) ? op->target : b->next;
+		break;
+	    case (0x0C):
+		program_counter = (unsigned short int)reg_file[op->rs];
+		break;
+	    case (0x13):
+		reg_file[op->rd] = b->next;
+		program_counter = (unsigned short int)reg_file[op->rs];
+		break;
+	    case (0x18):
+		program_counter = op->target;
+		break;
+	    case (0x0D):
+		clock_cycles[N_HALT] = 1;
+		*halt_all = 1;
+		program_counter = b->start + 2 * i;
+		break;
+	    case (0x0E):
+		*guest_out << "\t$R" << (int)op->rs << ": " << reg_file[op->rs] << "\n";
+		break;
+	    default:
+		if (perf_opcode(op->opcode)) {
+		    fast_perf(b, i);
+		    break;
+		}
+		*guest_out << "Invalid Opcode: " << (unsigned short int)op->opcode << endl;
+		break;
+	}
+    }
+
+    fast_count(b, 1);
+
+    return b->length;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Pure block, its index and the halting flag
+// Outputs: Instructions executed
+// Description: Copies the block's outcome from the memo table when it
+//              already ran from the same live-in registers, otherwise
+//              runs it and records the outcome. Blocks whose first
+//              MEMO_TRIAL lookups hit less than a quarter of the time
+//              are not looked up again.
+// /////////////////////////////////////////////////////////////////
+static unsigned int fast_memo(struct xblock * b, int index, short int * halt_all) {
+    struct memo_entry * entry;		// Slot for the live-in registers
+    short int key[8];			// Live-in registers, the rest zero
+    unsigned int executed;		// Instructions executed
+    int hit;				// Entry holds this block and key
+    int i;				// Count variable
+
+    for (i = 0; i < 8; i++) {
+	key[i] = (b->live_in & (1 << i)) ? reg_file[i] : 0;
+    }
+
+    entry = memo_slot(index, key);
+    hit = (entry->block == index) && (memcmp(entry->in, key, sizeof(key)) == 0);
+    memo_lookups++;
+
+    if (b->memo_tries < MEMO_TRIAL) {
+	b->memo_tries++;
+	b->memo_hits += hit;
+	if ((b->memo_tries == MEMO_TRIAL) && (b->memo_hits < MEMO_TRIAL / 4)) {
+	    b->memo = 0;
+	    memo_rejected++;
+	}
+    }
+
+    if (hit) {
+	memo_hits++;
+	for (i = 0; i < 8; i++) {
+	    if (b->live_out & (1 << i)) {
+		reg_file[i] = entry->out[i];
+	    }
+	}
+	program_counter = entry->next;
+
+	fast_count(b, 1);
+	return b->length;
+    }
+
+    // Faulting runs are not recorded
+    executed = fast_block(b, halt_all);
+    if (executed == b->length) {
+	entry->block = index;
+	entry->next = program_counter;
+	memcpy(entry->in, key, sizeof(key));
+	memcpy(entry->out, reg_file, sizeof(entry->out));
+	memo_stores++;
+    }
+
+    return executed;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Bank and address of a LW/SW on the first trip, +1 or -1 for
+//         the direction it moves in by one word a trip
+// Outputs: Trips before it would fault
+// /////////////////////////////////////////////////////////////////
+static unsigned long long fast_bulk_safe(unsigned int bank, unsigned short int addr, int direction) {
+
+    if (mem_check(bank, addr)) {
+	return 0;
+    }
+    if (mem_size == MEM_SIZE) {
+	return ~0ULL;
+    }
+
+    return (direction > 0) ? (mem_size - addr) / 2 : addr / 2 + 1;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: LOOP_BULK block and the most trips allowed
+// Outputs: Instructions executed, 0 if no trip was run
+// Description: Runs whole trips of a memset or memcpy style loop as
+//              page-sized memset/memmove calls on data memory. Trips
+//              stop short of the first LW/SW that would fault, which
+//              fast_block then runs to fault at the same instruction
+//              as run_engine. A copy whose stores reach words it has
+//              yet to load is run as far as the first such word at a
+//              time, so every load still sees what it would have.
+//              The fast engine is never used with --watch, whose
+//              watchpoints have to see every LW and SW.
+// /////////////////////////////////////////////////////////////////
+static unsigned long long fast_bulk(struct xblock * b, unsigned long long limit) {
+    const struct xop * op = &block_ops[b->first];
+    const struct xop * load = 0;	// LW of the body, if any
+    const struct xop * store = 0;	// SW of the body
+    unsigned short int step[8];		// Per-trip step of each register
+    unsigned short int offset[8];	// Steps taken before each LW/SW
+    unsigned short int dst, src;	// Addresses on the first trip
+    unsigned int dst_bank, src_bank;
+    unsigned long long trips;		// Trips run
+    unsigned long long exits;		// Trips until the branch falls through
+    unsigned long long safe;		// Trips before an access faults
+    unsigned long long left;		// Trips still to copy or fill
+    unsigned int words;			// Words of one memset/memmove call
+    unsigned int span;			// Words left in a page
+    unsigned char * to;			// Page being stored to
+    short int value;			// Stored by a fill, last loaded by a copy
+    int direction;			// Addresses go up (1) or down (-1)
+    unsigned int i, k;			// Count variables
+
+    exits = block_trips(op, b->length, reg_file, step);
+    if ((exits == 0) || (limit == 0)) {
+	return 0;
+    }
+
+    memset(offset, 0, sizeof(offset));
+    dst = src = 0;
+    for (i = 0; i + 1 < b->length; i++) {
+	switch (op[i].opcode) {
+	    case (0x00):
+		offset[op[i].rd] += reg_file[op[i].rt];
+		break;
+	    case (0x01):
+		offset[op[i].rd] -= reg_file[op[i].rt];
+		break;
+	    case (0x08):
+		load = &op[i];
+		src = reg_file[load->rs] + offset[load->rs];
+		break;
+	    case (0x09):
+		store = &op[i];
+		dst = reg_file[store->rs] + offset[store->rs];
+		break;
+	}
+    }
+
+    // One word a trip, both addresses the same way
+    if ((step[store->rs] != 2) && (step[store->rs] != 0xFFFE)) {
+	return 0;
+    }
+    direction = (step[store->rs] == 2) ? 1 : -1;
+    if (load && (step[load->rs] != step[store->rs])) {
+	return 0;
+    }
+
+    trips = min(exits, limit);
+    dst_bank = mem_bank(0x09, store->rd, store->rt);
+    safe = fast_bulk_safe(dst_bank, dst, direction);
+    src_bank = 0;
+    if (load) {
+	src_bank = mem_bank(0x08, load->rd, load->rt);
+	safe = min(safe, fast_bulk_safe(src_bank, src, direction));
+
+	// Trip k loads what trip k - distance stored
+	if (src_bank == dst_bank) {
+	    left = (unsigned short int)((dst - src) * direction) / 2;
+	    if (left) {
+		trips = min(trips, left);
+	    }
+	}
+    }
+    trips = min(trips, safe);
+    if (trips == 0) {
+	return 0;
+    }
+
+    if (load) {
+	value = mem_load(src_bank, src + direction * 2 * (trips - 1));
+    }
+    else {
+	value = reg_file[store->rt];
+    }
+
+    // Whole runs of words within one page of each side
+    for (left = trips; left > 0; left -= words) {
+	span = (direction > 0) ? (MEM_PAGE_SIZE - (dst & (MEM_PAGE_SIZE - 1))) / 2 : (dst & (MEM_PAGE_SIZE - 1)) / 2 + 1;
+	words = min(left, (unsigned long long)span);
+	if (load) {
+	    span = (direction > 0) ? (MEM_PAGE_SIZE - (src & (MEM_PAGE_SIZE - 1))) / 2 : (src & (MEM_PAGE_SIZE - 1)) / 2 + 1;
+	    words = min(words, span);
+	}
+
+	k = (dst_bank << (16 - MEM_PAGE_BITS)) | (dst >> MEM_PAGE_BITS);
+	to = mem_write_pages[k] ? mem_write_pages[k] : mem_page_alloc(k);
+	to += ((direction > 0) ? dst : dst - 2 * (words - 1)) & (MEM_PAGE_SIZE - 1);
+
+	if (load) {
+	    k = (src_bank << (16 - MEM_PAGE_BITS)) | (src >> MEM_PAGE_BITS);
+	    memmove(to, mem_pages[k] + (((direction > 0) ? src : src - 2 * (words - 1)) & (MEM_PAGE_SIZE - 1)), 2 * words);
+	    src += direction * 2 * words;
+	}
+	else if (((value >> 8) & 0x00FF) == (value & 0x00FF)) {
+	    memset(to, value & 0x00FF, 2 * words);
+	}
+	else {
+	    for (i = 0; i < words; i++) {
+		to[2 * i] = (value >> 8) & 0x00FF;
+		to[2 * i + 1] = value & 0x00FF;
+	    }
+	}
+	dst += direction * 2 * words;
+    }
+
+    for (i = 0; i < 8; i++) {
+	reg_file[i] = (unsigned short int)(reg_file[i] + trips * step[i]);
+    }
+    if (load) {
+	reg_file[load->rd] = value;
+    }
+
+    fast_count(b, trips);
+    program_counter = (trips == exits) ? b->next : b->start;
+
+    return trips * b->length;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Self loop block and the most trips allowed
+// Outputs: Instructions executed, 0 if no trip completed
+// Description: Runs whole trips of the loop, leaving program_counter
+//              at the block while it is still looping. A trip that
+//              would fault is undone and left to fast_block.
+// /////////////////////////////////////////////////////////////////
+static unsigned long long fast_loop(struct xblock * b, unsigned long long limit) {
+    const struct xop * op = &block_ops[b->first];
+    const struct xop * branch = op + b->length - 1;
+    unsigned short int step[8];		// Per-trip step of each register
+    short int saved[8];			// Registers before a trip
+    unsigned long long trips;		// Trips completed
+    int taken;				// Branch went back to the block
+    unsigned int i;			// Count variable
+
+    if (limit == 0) {
+	return 0;
+    }
+
+    if (b->loop == LOOP_BULK) {
+	return fast_bulk(b, limit);
+    }
+
+    if (b->loop == LOOP_INDUCTION) {
+	trips = block_trips(op, b->length, reg_file, step);
+	if (trips && (trips <= limit)) {
+	    for (i = 0; i < 8; i++) {
+		reg_file[i] = (unsigned short int)(reg_file[i] + trips * step[i]);
+	    }
+	    fast_count(b, trips);
+	    program_counter = b->next;
+	    return trips * b->length;
+	}
+    }
+
+    trips = 0;
+    taken = 1;
+    while (taken && (trips < limit)) {
+	if (b->flags & BLOCK_CAN_FAULT) {
+	    memcpy(saved, reg_file, sizeof(saved));
+	}
+	for (i = 0; i + 1 < b->length; i++) {
+	    if (!fast_alu(&op[i])) {
+		break;
+	    }
+	}
+	if (i + 1 < b->length) {
+	    memcpy(reg_file, saved, sizeof(saved));
+	    break;
+	}
+	taken = fast_taken(branch);
+	trips++;
+    }
+
+    fast_count(b, trips);
+    program_counter = taken ? b->start : b->next;
+
+    return trips * b->length;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Halting flag
+// Description: Executes one instruction with its x_* handler
+// /////////////////////////////////////////////////////////////////
+static void fast_step(short int * halt_all) {
+    short int instruction;		// 16-Bit value of instruction
+    unsigned short int opcode;		// Opcode Value
+
+    instruction = (unsigned short int)(inst_memory[program_counter] << 8) | (unsigned short int)(inst_memory[program_counter + 1]);
+    get_opcode(instruction, &opcode);
+    // Counters read by --perf-isa include the blocks not yet flushed
+    if (perf_opcode(opcode)) {
+	block_flush();
+    }
+    engine_dispatch(instruction, opcode, halt_all);
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Outputs: Halting flag, 0 when execution stopped on an error
+// Description: Executes from program_counter until HALT or an error.
+//              Periodic work lands on the same instruction as in
+//              run_engine: blocks and loops only run whole while they
+//              fit before it, the rest is stepped one instruction at
+//              a time.
+// /////////////////////////////////////////////////////////////////
+short int run_fast() {
+    short int halt_all;				// Halting Flag
+    struct xblock * b;				// Block at program_counter
+    int index;					// Index of b in blocks
+    unsigned long long executed;		// Instructions just executed
+    long long periodic_countdown;		// Instructions until periodic work
+    long long periodic_span;			// Instructions between periodic work
+
+    halt_all = 0;
+
+    periodic_span = periodic_next();
+    periodic_countdown = periodic_span;
+
+    while ((!halt_all) && (program_counter != (unsigned short int)-1)) {
+
+	    executed = 0;
+
+	    // Jumps to odd addresses are stepped
+	    if (!(program_counter & 0x0001)) {
+		index = block_find(program_counter);
+		b = &blocks[index];
+		if (b->loop != LOOP_NONE) {
+		    executed = fast_loop(b, (periodic_countdown > 0) ? periodic_countdown / b->length : ~0ULL);
+		}
+		if (!executed && ((periodic_countdown < 0) || (periodic_countdown >= b->length))) {
+		    if (memo_enabled && b->memo && (b->flags & BLOCK_PURE)) {
+			executed = fast_memo(b, index, &halt_all);
+		    }
+		    else {
+			executed = fast_block(b, &halt_all);
+		    }
+		}
+	    }
+
+	    if (!executed) {
+		fast_step(&halt_all);
+		executed = 1;
+	    }
+
+	    // Periodic work such as publishing live metrics or run limits
+	    if (periodic_countdown > 0) {
+		periodic_countdown -= executed;
+		if (periodic_countdown == 0) {
+		    block_flush();
+		    if (periodic_events(periodic_span)) {
+			break;
+		    }
+		    periodic_span = periodic_next();
+		    periodic_countdown = periodic_span;
+		}
+	    }
+    }
+
+    block_flush();
+
+    return halt_all;
+}
@@ -0,0 +1,171 @@
+// //////////////////////////////////////////////////////////////////
+// File: xinterval.cpp
+// Description: Every interval_length instructions one JSON object is
+//              appended to the interval file, holding the registers and
+//              the change of every stats counter since the previous
+//              line, with the same keys as the output file. Lines are
+//              formatted into a private buffer that is written when it
+//              fills up or once a second, so a killed run keeps all but
+//              its last moments.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xinterval.h"
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Size of the write buffer
+#define INTERVAL_BUFFER_SIZE 65536
+// Room reserved for one line
+#define INTERVAL_LINE_SIZE 2048
+// Nanoseconds between forced writes
+#define INTERVAL_FLUSH_NS 1000000000ULL
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread unsigned long long clock_cycles[22];
+extern __thread int latency_vals[8];
+extern __thread short int reg_file[8];
+extern __thread unsigned short int program_counter;
+// //////////////////////////////////////////
+
+long long interval_length = 0;			// Instructions per interval
+
+int interval_fd = -1;				// Interval file
+char interval_buffer[INTERVAL_BUFFER_SIZE];	// Pending output
+int interval_used;				// Bytes pending
+long long interval_number;			// Lines written
+unsigned long long interval_previous[22];	// Counters at the previous line
+unsigned long long interval_flushed_ns;		// Time of the last write
+
+// Monotonic clock in nanoseconds
+static unsigned long long interval_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Write everything pending
+static void interval_flush() {
+    int done;
+    int count;
+
+    done = 0;
+    while (done < interval_used) {
+	count = write(interval_fd, interval_buffer + done, interval_used - done);
+	if (count <= 0) {
+	    break;
+	}
+	done += count;
+    }
+
+    interval_used = 0;
+    interval_flushed_ns = interval_now();
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Name of the JSON Lines file
+// Outputs: 0 on success, -1 if the file could not be created
+// /////////////////////////////////////////////////////////////////
+int interval_open(const char * filename) {
+
+    interval_fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (interval_fd < 0) {
+	return -1;
+    }
+
+    interval_used = 0;
+    interval_number = 0;
+    interval_flushed_ns = interval_now();
+    memset(interval_previous, 0, sizeof(interval_previous));
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Appends one line with the registers and the counter
+//              deltas since the previous line
+// /////////////////////////////////////////////////////////////////
+void interval_emit() {
+    char * line;		// Where the line is formatted
+    int length;			// Bytes formatted so far
+    unsigned long long delta;	// Change of one counter
+    unsigned long long inst_count;	// Instructions in the interval
+    unsigned long long num_cycles;	// Cycles in the interval
+    int i;
+
+    if (interval_fd < 0) {
+	return;
+    }
+
+    if ((INTERVAL_BUFFER_SIZE - interval_used) < INTERVAL_LINE_SIZE) {
+	interval_flush();
+    }
+
+    line = interval_buffer + interval_used;
+    length = 0;
+
+    length += snprintf(line + length, INTERVAL_LINE_SIZE - length, "{\"interval\":%lld,\"pc\":%u,\"registers\":{",
+	    interval_number, program_counter);
+    for (i = 0; i < 8; i++) {
+	length += snprintf(line + length, INTERVAL_LINE_SIZE - length, "%s\"r%d\":%d", (i > 0) ? "," : "", i, reg_file[i]);
+    }
+
+    length += snprintf(line + length, INTERVAL_LINE_SIZE - length, "},\"stats\":{");
+    inst_count = 0;
+    num_cycles = 0;
+    for (i = 0; i < 22; i++) {
+	delta = clock_cycles[i] - interval_previous[i];
+	interval_previous[i] = clock_cycles[i];
+	inst_count += delta;
+	num_cycles += delta * ((i < 8) ? latency_vals[i] : 1);
+	length += snprintf(line + length, INTERVAL_LINE_SIZE - length, "\"%s\":%llu,", stat_names[i], delta);
+    }
+    length += snprintf(line + length, INTERVAL_LINE_SIZE - length, "\"instructions\":%llu,\"cycles\":%llu}}\n",
+	    inst_count, num_cycles);
+
+    interval_used += length;
+    interval_number++;
+
+    // Keep a killed run from losing more than about a second of lines
+    if ((interval_now() - interval_flushed_ns) >= INTERVAL_FLUSH_NS) {
+	interval_flush();
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Emits the last partial interval and closes the file
+// /////////////////////////////////////////////////////////////////
+void interval_close() {
+    unsigned long long pending;
+    int i;
+
+    if (interval_fd < 0) {
+	return;
+    }
+
+    // Only emit a final line if something ran since the previous one
+    pending = 0;
+    for (i = 0; i < 22; i++) {
+	pending += clock_cycles[i] - interval_previous[i];
+    }
+    if ((pending > 0) || (interval_number == 0)) {
+	interval_emit();
+    }
+
+    interval_flush();
+    close(interval_fd);
+    interval_fd = -1;
+
+    return;
+}
@@ -7,19 +7,30 @@
 // //////////////////////////////////////////////////////////////////
 
 #include "xlibrary.h"
+#include "xselfprof.h"
+#include "xwatch.h"
+#include "xmem.h"
 
 using namespace std;
 
 // //////////////////////////////////////////
 // Extern variables shared amoung files
-extern short int inst_memory[MEM_SIZE/2];
-extern char data_memory[MEM_SIZE];
-extern short int reg_file[8];
-extern short int program_counter;
-extern int clock_cycles[22];
-extern int latency_vals[8];
+extern __thread short int inst_memory[MEM_SIZE/2];
+extern __thread short int reg_file[8];
+extern __thread short int program_counter;
+extern __thread unsigned long long clock_cycles[22];
+extern __thread int latency_vals[8];
+extern __thread int trace_enabled;
 // //////////////////////////////////////////
 
+__thread ostream * guest_out = &cout;	// Guest output of this thread
+
+// Output names of the stat counters, in Instruction_Name order
+const char * stat_names[22] = {
+    "add", "sub", "and", "nor", "div", "mul", "mod", "exp", "lw", "sw", "liz",
+    "lis", "lui", "bp", "bn", "bx", "bz", "jr", "jal", "j", "halt", "put"
+};
+
 // /////////////////////////////////////////////////////////////////
 // Inputs: One 16-bit value
 // Outputs: First 5 bits of input
@@ -32,6 +43,80 @@ void get_opcode(unsigned short int inst, unsigned short int * op) {
     return;
 }
 
+// /////////////////////////////////////////////////////////////////
+// Inputs: One 5-bit opcode
+// Outputs: Matching Instruction_Name, or -1 for an invalid opcode
+// Description: This function maps opcodes to their stat counters
+// /////////////////////////////////////////////////////////////////
+int get_inst_name(unsigned short int op) {
+    static const signed char names[32] = {
+	N_ADD, N_SUB, N_AND, N_NOR, N_DIV, N_MUL, N_MOD, N_EXP,
+	N_LW, N_SW, -1, -1, N_JR, N_HALT, N_PUT, -1,
+	N_LIZ, N_LIS, N_LUI, N_JAL, N_BP, N_BN, N_BX, N_BZ,
+	N_J, -1, -1, -1, -1, -1, -1, -1
+    };
+
+    return names[op & 0x001F];
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Base and power register values
+// Outputs: Result of EXP as stored in the destination register
+// Description: Shared by every engine so they truncate alike
+// /////////////////////////////////////////////////////////////////
+short int exp_value(short int base, short int power) {
+
+    return (short int)pow(base, power);
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: One 16-bit instruction
+// Description: Starts the trace line of a fetched instruction
+// /////////////////////////////////////////////////////////////////
+void trace_fetch(short int inst) {
+    int previous = SP_DISPATCH;	// Self profiling bucket to return to
+
+    if (!trace_enabled) {
+	return;
+    }
+
+    if (selfprof_enabled) {
+	previous = selfprof_switch(SP_TRACE);
+    }
+
+    *guest_out << hex << inst << "\t" << dec;
+
+    if (selfprof_enabled) {
+	selfprof_switch(previous);
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Mnemonic of the instruction that executed
+// Description: Finishes the trace line of an instruction
+// /////////////////////////////////////////////////////////////////
+void trace_inst(const char * name) {
+    int previous = SP_DISPATCH;	// Self profiling bucket to return to
+
+    if (!trace_enabled) {
+	return;
+    }
+
+    if (selfprof_enabled) {
+	previous = selfprof_switch(SP_TRACE);
+    }
+
+    *guest_out << name << endl;
+
+    if (selfprof_enabled) {
+	selfprof_switch(previous);
+    }
+
+    return;
+}
+
 // //////////////////////////////////////////////////////////////////
 // Inputs: One 16-Bit value
 // Outputs: Three values corresponding to register numbers
@@ -89,7 +174,7 @@ short int x_add(short int inst) {
 
     // Increment Frequency count
     clock_cycles[N_ADD] += (1);
-    cout << "ADD" << endl;
+    trace_inst("ADD");
 
 #ifdef DEBUG
     cout << "RD: " << (rd) << endl;
@@ -113,7 +198,7 @@ short int x_sub(short int inst) {
 
     // Increment Frequency count
     clock_cycles[N_SUB] += (1);;
-    cout << "SUB" << endl;
+    trace_inst("SUB");
 
 #ifdef DEBUG
     cout << "RD: " << (rd) << endl;
@@ -136,7 +221,7 @@ short int x_and(short int inst) {
 
     // Increment Frequency Count
     clock_cycles[N_AND] += (1);
-    cout << "AND" << endl;
+    trace_inst("AND");
 
 #ifdef DEBUG
     cout << "RD: " << (rd) << endl;
@@ -160,7 +245,7 @@ short int x_nor(short int inst) {
 
     // Increment Frequency Count
     clock_cycles[N_NOR] += (1);
-    cout << "NOR" << endl;
+    trace_inst("NOR");
 
 #ifdef DEBUG
     cout << "RD: " << (rd) << endl;
@@ -181,7 +266,7 @@ short int x_div(short int inst) {
 
     // Check for DIVIDE BY ZERO
     if (reg_file[rt] == 0) {
-	cout << "Divide by 0 Error...Terminating\n";
+	*guest_out << "Divide by 0 Error...Terminating\n";
 	return (unsigned short int) -1;
     }
 
@@ -190,7 +275,7 @@ short int x_div(short int inst) {
 
     // Increment Frequency count
     clock_cycles[N_DIV] += (1);
-    cout << "DIV" << endl;
+    trace_inst("DIV");
 
 #ifdef DEBUG
     cout << "RD: " << (rd) << endl;
@@ -214,7 +299,7 @@ short int x_mul(short int inst) {
 
     // Increment frequency count
     clock_cycles[N_MUL] += (1);
-    cout << "MUL" << endl;
+    trace_inst("MUL");
 
 #ifdef DEBUG
     cout << "RD: " << (rd) << endl;
@@ -235,7 +320,7 @@ short int x_mod(short int inst) {
 
     // Check for MOD BY ZERO error
     if (reg_file[rt] == 0){
-	cout << "Cannot MOD by 0...terminating\n";
+	*guest_out << "Cannot MOD by 0...terminating\n";
 	return (unsigned short int) -1;
     }
 
@@ -244,7 +329,7 @@ short int x_mod(short int inst) {
 
     // Increment frequency count
     clock_cycles[N_MOD] += (1);
-    cout << "MOD" << endl;
+    trace_inst("MOD");
 
 #ifdef DEBUG
     cout << "RD: " << (rd) << endl;
@@ -264,11 +349,11 @@ short int x_exp(short int inst) {
     r_type_field(inst, &rd, &rs, &rt);
 
     // perform exponentiation
-    reg_file[rd] = (short int)pow(reg_file[rs], reg_file[rt]);
+    reg_file[rd] = exp_value(reg_file[rs], reg_file[rt]);
 
     // Increment Frequency count
     clock_cycles[N_EXP] += (1);
-    cout << "EXP" << endl;
+    trace_inst("EXP");
 
 #ifdef DEBUG	
     cout << "RD: " << (rd) << endl;
@@ -283,67 +368,87 @@ short int x_exp(short int inst) {
 
 short int x_lw(short int inst) {
     short int rs, rt, rd;		// Integer values for registers
-    unsigned short int temp1, temp2; 	// temporary holders for half-words
+    unsigned short int addr;		// Address loaded from
+    unsigned int bank;			// Bank loaded from
+    const char * fault;			// Why the access is not allowed
 
     // Get register values
     r_type_field(inst, &rd, &rs, &rt);
 
-    // Check for word-aligned address
-    if ((unsigned short int)reg_file[rs] & 0x0001) {
-	cout << "Address not word aligned...terminating" << endl;
+    addr = (unsigned short int)reg_file[rs];
+    bank = mem_bank(0x08, rd, rt);
+
+    // Check for a word-aligned address in range
+    fault = mem_check(bank, addr);
+    if (fault) {
+	*guest_out << fault << endl;
 	return (unsigned short int) -1;
     } 
 
-    temp1 = 0;
-    temp2 = 0;
-
-    // Copy data from memory to temp variables
-    memcpy(&temp1, &data_memory[((unsigned short int)reg_file[rs])], sizeof(char));
-    memcpy(&temp2, &data_memory[((unsigned short int)reg_file[rs]+1)], sizeof(char));
-
     // Store memory value in register
-    reg_file[rd] = (temp1 << 8) | temp2;
+    reg_file[rd] = mem_load(bank, addr);
     
     // Increment frequency count
     clock_cycles[N_LW] += 1;
-    cout << "LW" << endl;
+    trace_inst("LW");
+
+    // Check watchpoints
+    if ((bank == 0) && watch_test(addr) && watch_hit(WATCH_READ, addr, reg_file[rd], reg_file[rd])) {
+	return (unsigned short int) -1;
+    }
 
 #ifdef DEBUG
     cout << "RD: " << (rd) << endl;
     cout << "RS: " << (rs) << endl;
     cout << "RT: " << (rt) << endl;
 
-    cout << "RD <- MEM[RS]" << endl << hex << reg_file[rd] << " <- " << (unsigned short int)data_memory[rs] << (unsigned short int)data_memory[rs+1] << dec << endl;
+    cout << "RD <- MEM[RS]" << endl << hex << reg_file[rd] << " <- " << mem_load(bank, addr) << dec << endl;
 #endif
 
     return (unsigned short int) (program_counter + 2);
 }
 short int x_sw(short int inst) {
     short int rs, rt, rd;	// Integer values for registers
-    unsigned short int temp; 	// temporary value 
+    unsigned short int addr;	// Address stored to
+    unsigned int bank;		// Bank stored to
+    const char * fault;		// Why the access is not allowed
+    int watched;		// A watchpoint covers the address
+    short int old_value;	// Word before the store
 
     // Get register numbers
     r_type_field(inst, &rd, &rs, &rt);
 
-    // Check for word aligned address
-    if ((unsigned short int)reg_file[rs] & 0x0001) {
-	cout << "Address not word aligned...terminating" << endl;
+    addr = (unsigned short int)reg_file[rs];
+    bank = mem_bank(0x09, rd, rt);
+
+    // Check for a word-aligned address in range
+    fault = mem_check(bank, addr);
+    if (fault) {
+	*guest_out << fault << endl;
 #ifdef DEBUG
 	cout << "RS: " << rs << endl << (unsigned short int)reg_file[rs] << endl;
 #endif
 	return (unsigned short int) -1;
     } 
 
-    // Copy 8-Bits to temp and store to memory
-    temp = (reg_file[rt] >> 8) & 0x00FF;
-    memcpy(&data_memory[(unsigned short int)reg_file[rs]], &temp, sizeof(char));
-    // Copy Next 8-Bits to temp and store to memory
-    temp = (reg_file[rt]) & 0x00FF;
-    memcpy(&data_memory[((unsigned short int)reg_file[rs])+1], &temp, sizeof(char));
+    // Keep the old word for watchpoints
+    watched = (bank == 0) && watch_test(addr);
+    old_value = 0;
+    if (watched) {
+	old_value = mem_load(bank, addr);
+    }
+
+    // Store the word, high byte first
+    mem_store(bank, addr, reg_file[rt]);
 
     // Increment frequency count
     clock_cycles[N_SW] += 1;
-    cout << "SW" << endl;
+    trace_inst("SW");
+
+    // Check watchpoints
+    if (watched && watch_hit(WATCH_WRITE, addr, old_value, reg_file[rt])) {
+	return (unsigned short int) -1;
+    }
 
 #ifdef DEBUG
     cout << (rs >> 1) << endl;
@@ -352,10 +457,7 @@ short int x_sw(short int inst) {
     cout << "RS: " << (rs) << endl;
     cout << "RT: " << (rt) << endl;
 
-    cout << "Reg1: " << hex << ((unsigned short int)(reg_file[rt] >> 8) & 0x00FF) << "\t" << (unsigned short int)data_memory[(unsigned short int)reg_file[rs]] << dec << endl;
-    cout << "Reg2: " << hex << ((unsigned short int)reg_file[rt] & 0x00FF) << "\t" << (unsigned short int)data_memory[(unsigned short int)reg_file[rs]+1] << dec << endl;
-
-    cout << "MEM[RS] <- RT" << endl << hex << (unsigned short int)data_memory[rs] << (unsigned short int)data_memory[rs+1] << " <- " << reg_file[rt] << dec << endl;
+    cout << "MEM[RS] <- RT" << endl << hex << mem_load(bank, addr) << " <- " << reg_file[rt] << dec << endl;
 #endif
 
     return (unsigned short int) (program_counter + 2);
@@ -372,7 +474,7 @@ short int x_liz(short int inst) {
 
     // Increment frequency count
     clock_cycles[N_LIZ] += 1;
-    cout << "LIZ" << endl;
+    trace_inst("LIZ");
 
 #ifdef DEBUG
     cout << "RD: " << (rd) << endl;
@@ -401,7 +503,7 @@ short int x_lis(short int inst) {
 
     // Increment frequency count
     clock_cycles[N_LIS] += 1;
-    cout << "LIS" << endl;
+    trace_inst("LIS");
 
 #ifdef DEBUG
     cout << "RD: " << (rd) << endl;
@@ -421,7 +523,7 @@ short int x_lui(short int inst) {
 
     // Increment frequency count
     clock_cycles[N_LUI] += 1;
-    cout << "LUI" << endl;
+    trace_inst("LUI");
 
 #ifdef DEBUG
     cout << "RD: " << rd << endl;
@@ -456,7 +558,7 @@ short int x_bp(short int inst) {
 
     // Increment frequency count
     clock_cycles[N_BP] += 1;
-    cout << "BP" << endl;
+    trace_inst("BP");
 
 #ifdef DEBUG
     cout << "RD: " << rd << endl;
@@ -485,7 +587,7 @@ short int x_bn(short int inst) {
 
     // Increment frequency count
     clock_cycles[N_BN] += 1;
-    cout << "BN" << endl;
+    trace_inst("BN");
 
 #ifdef DEBUG
     cout << "RD: " << rd << endl;
@@ -514,7 +616,7 @@ short int x_bx(short int inst) {
 
     // Increment Frequency count
     clock_cycles[N_BX] += 1;
-    cout << "BX" << endl;
+    trace_inst("BX");
 
 #ifdef DEBUG
     cout << "RD: " << rd << endl;
@@ -543,7 +645,7 @@ short int x_bz(short int inst) {
 
     // Increment Frequency count
     clock_cycles[N_BZ] += 1;
-    cout << "BZ" << endl;
+    trace_inst("BZ");
 
 #ifdef DEBUG
     cout << "RD: " << rd << endl;
@@ -567,7 +669,7 @@ short int x_jr(short int inst) {
 
     // Increment frequency count
     clock_cycles[N_JR] += 1;
-    cout << "JR" << endl;
+    trace_inst("JR");
 
 #ifdef DEBUG
     cout << "RS: " << rs << endl;
@@ -592,7 +694,7 @@ short int x_jalr(short int inst) {
 
     // Increment frequency count
     clock_cycles[N_JAL] += 1;
-    cout << "JALR" << endl;
+    trace_inst("JALR");
 
 #ifdef DEBUG
     cout << "RD: " << rd << endl;
@@ -616,7 +718,7 @@ short int x_j(short int inst) {
 
     // Increment Frequency Count
     clock_cycles[N_J] += 1;
-    cout << "J" << endl;
+    trace_inst("J");
 
 #ifdef DEBUG
     cout << "IMM11: " << hex << imm11 << dec << endl;
@@ -635,9 +737,7 @@ short int x_halt(short int inst) {
 
     // Increment frequency count
     clock_cycles[N_HALT] = 1;
-#if 1
-    cout << "HALT" << endl;
-#endif
+    trace_inst("HALT");
 
     return (short int) 1;
 }
@@ -650,13 +750,13 @@ short int x_put(short int inst) {
 
     // Increment frequency count
     clock_cycles[N_PUT] += 1;
-    cout << "PUT" << endl;
+    trace_inst("PUT");
 
 #ifdef DEBUG
     cout << "RS: " << rs << endl;
 #endif
 
     // Print value in register to STDOUT
-    fprintf(stdout, "\t$R%d: %d\n", rs, reg_file[rs]);
+    *guest_out << "\t$R" << rs << ": " << reg_file[rs] << "\n";
     return (unsigned short int) (program_counter + 2);
 }
@@ -0,0 +1,219 @@
+// //////////////////////////////////////////////////////////////////
+// File: xlive.cpp
+// Description: Publishes progress of the running simulation into a
+//              shared memory segment every LIVE_PERIOD instructions so
+//              that xsim-top can follow it. The segment of a finished
+//              run is left for LIVE_LINGER_SECONDS with its final state;
+//              xsim-top and later runs remove it after that.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xlibrary.h"
+#include "xlive.h"
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+
+using namespace std;
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread unsigned long long clock_cycles[22];
+extern __thread unsigned short int program_counter;
+// //////////////////////////////////////////
+
+int live_enabled = 0;			// Live metrics flag
+
+struct live_metrics * live = 0;		// Mapped segment
+char live_name[64];			// Segment name
+unsigned long long live_last_ns;	// Time of previous update
+unsigned long long live_last_insts;	// Instructions at previous update
+
+// Wall clock in nanoseconds
+static unsigned long long wall_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Removes the segments of other runs that finished more
+//              than LIVE_LINGER_SECONDS ago or were killed, in case no
+//              xsim-top was watching them
+// /////////////////////////////////////////////////////////////////
+static void live_sweep() {
+    struct live_metrics * other;	// Mapped segment of another run
+    struct live_metrics copy;
+    struct dirent * entry;
+    DIR * dir;
+    char name[300];
+    unsigned long long now;
+    int fd;
+
+    dir = opendir(LIVE_SHM_DIR);
+    if (!dir) {
+	return;
+    }
+
+    now = wall_ns();
+    while ((entry = readdir(dir)) != 0) {
+	if (strncmp(entry->d_name, LIVE_SHM_PREFIX + 1, strlen(LIVE_SHM_PREFIX) - 1) != 0) {
+	    continue;
+	}
+	snprintf(name, sizeof(name), "/%s", entry->d_name);
+	if (strcmp(name, live_name) == 0) {
+	    continue;
+	}
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0) {
+	    continue;
+	}
+	other = (struct live_metrics *)mmap(0, sizeof(struct live_metrics), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (other == MAP_FAILED) {
+	    continue;
+	}
+	memcpy(&copy, other, sizeof(copy));
+	munmap(other, sizeof(struct live_metrics));
+
+	if ((copy.magic == LIVE_MAGIC) && live_expired(&copy, now)) {
+	    shm_unlink(name);
+	}
+    }
+
+    closedir(dir);
+
+    return;
+}
+
+// Remove the segment if the program exits early
+static void live_unlink() {
+
+    if (live) {
+	munmap(live, sizeof(struct live_metrics));
+	live = 0;
+	shm_unlink(live_name);
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Name of the guest program
+// Outputs: 0 on success, -1 if the segment could not be created
+// Description: Creates and maps /xsim.<pid>
+// /////////////////////////////////////////////////////////////////
+int live_open(const char * program) {
+    int fd;
+
+    snprintf(live_name, sizeof(live_name), "%s%d", LIVE_SHM_PREFIX, (int)getpid());
+
+    fd = shm_open(live_name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+	return -1;
+    }
+
+    if (ftruncate(fd, sizeof(struct live_metrics)) != 0) {
+	close(fd);
+	shm_unlink(live_name);
+	return -1;
+    }
+
+    live = (struct live_metrics *)mmap(0, sizeof(struct live_metrics), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (live == MAP_FAILED) {
+	live = 0;
+	shm_unlink(live_name);
+	return -1;
+    }
+
+    live->magic = LIVE_MAGIC;
+    live->version = LIVE_VERSION;
+    live->pid = getpid();
+    strncpy(live->program, program, sizeof(live->program) - 1);
+    live->start_ns = wall_ns();
+
+    live_last_ns = live->start_ns;
+    live_last_insts = 0;
+
+    atexit(live_unlink);
+
+    live_publish(LIVE_RUNNING);
+
+    live_sweep();
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Live_State to report
+// Description: Copies the current counters into the segment
+// /////////////////////////////////////////////////////////////////
+void live_publish(int state) {
+    unsigned long long now;		// Time of this update
+    unsigned long long inst_count;	// Guest instructions so far
+    unsigned int sequence;
+    int i;
+
+    if (!live) {
+	return;
+    }
+
+    now = wall_ns();
+
+    inst_count = 0;
+    for (i = 0; i < 22; i++) {
+	inst_count += clock_cycles[i];
+    }
+
+    // Enter the write side of the sequence lock
+    sequence = live->sequence;
+    __atomic_store_n(&live->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    live->state = state;
+    live->program_counter = program_counter;
+    live->update_ns = now;
+    live->instructions = inst_count;
+    for (i = 0; i < 22; i++) {
+	live->clock_cycles[i] = clock_cycles[i];
+    }
+    if (now > live_last_ns) {
+	live->mips = (double)(inst_count - live_last_insts) * 1000.0 / (now - live_last_ns);
+    }
+    if (now > live->start_ns) {
+	live->average_mips = (double)inst_count * 1000.0 / (now - live->start_ns);
+    }
+
+    // Leave the write side
+    __atomic_store_n(&live->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    live_last_ns = now;
+    live_last_insts = inst_count;
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Final Live_State
+// Description: Publishes the final counters and unmaps the segment,
+//              which stays for readers until it expires
+// /////////////////////////////////////////////////////////////////
+void live_close(int state) {
+
+    live_publish(state);
+
+    if (live) {
+	munmap(live, sizeof(struct live_metrics));
+	live = 0;
+    }
+
+    return;
+}
@@ -0,0 +1,286 @@
+// //////////////////////////////////////////////////////////////////
+// File: xmem.cpp
+// Description: Data memory as a table of pages. Every page starts out
+//              reading one shared page of zeros, or its part of an
+//              input image mapped read-only with --data-in, and gets a
+//              copy of its own the first time something is stored to
+//              it. Starting a run then costs nothing however large the
+//              address space or the image, runs from one image share
+//              its pages through the page cache, and the host memory
+//              used grows with the pages the program stores to. Beyond
+//              the single 64 KB bank the ISA addresses, --mem-banks
+//              lets LW and SW pick one of up to MEM_MAX_BANKS banks
+//              with their unused register field.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xmem.h"
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+#include <algorithm>
+#include <string>
+
+using namespace std;
+
+__thread const unsigned char * mem_pages[MEM_MAX_BANKS * MEM_BANK_PAGES];	// Page read at each address
+__thread unsigned char * mem_write_pages[MEM_MAX_BANKS * MEM_BANK_PAGES];	// Own copy of the page, or 0
+const unsigned char mem_zero_page[MEM_PAGE_SIZE] = {0};				// Shared page of zeros
+__thread unsigned int mem_size = MEM_SIZE;					// Bytes addressable in each bank
+__thread unsigned int mem_banks = 1;					// Banks LW/SW can select
+int mem_stats_enabled = 0;							// Print the memory report
+
+static thread_local vector<unsigned int> mem_owned;		// Pages with their own copy
+static __thread const unsigned char * mem_image = 0;	// Mapped input image
+static __thread size_t mem_image_size = 0;			// Bytes in the input image
+static __thread int mem_cleared = 0;				// mem_pages has been filled once
+
+// /////////////////////////////////////////////////////////////////
+// Outputs: Bytes from the start of bank 0 to the end of the last bank
+// /////////////////////////////////////////////////////////////////
+static size_t mem_extent() {
+
+    return (size_t)(mem_banks - 1) * MEM_SIZE + mem_size;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Clears data memory by freeing every page stored to
+//              and unmapping the input image. Only those pages point
+//              anywhere but the zero page, so only they are reset
+//              after the first call on a thread.
+// /////////////////////////////////////////////////////////////////
+void mem_reset() {
+    unsigned int pages;			// Pages the image covers
+    unsigned int i;			// Count variable
+
+    if (!mem_cleared) {
+	for (i = 0; i < MEM_MAX_BANKS * MEM_BANK_PAGES; i++) {
+	    mem_pages[i] = mem_zero_page;
+	}
+	mem_cleared = 1;
+    }
+
+    for (i = 0; i < mem_owned.size(); i++) {
+	free(mem_write_pages[mem_owned[i]]);
+	mem_write_pages[mem_owned[i]] = 0;
+	mem_pages[mem_owned[i]] = mem_zero_page;
+    }
+    mem_owned.clear();
+
+    if (mem_image) {
+	pages = (mem_image_size + MEM_PAGE_SIZE - 1) / MEM_PAGE_SIZE;
+	for (i = 0; i < pages; i++) {
+	    mem_pages[i] = mem_zero_page;
+	}
+	munmap((void *)mem_image, mem_image_size);
+	mem_image = 0;
+	mem_image_size = 0;
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Index of a page without its own copy
+// Outputs: The page's own copy of what it read until now
+// /////////////////////////////////////////////////////////////////
+unsigned char * mem_page_alloc(unsigned int page) {
+    unsigned char * p;
+
+    p = (unsigned char *)malloc(MEM_PAGE_SIZE);
+    if (!p) {
+	cout << "Unable to allocate data memory...terminating" << endl;
+	exit(-1);
+    }
+    memcpy(p, mem_pages[page], MEM_PAGE_SIZE);
+
+    mem_pages[page] = p;
+    mem_write_pages[page] = p;
+    mem_owned.push_back(page);
+
+    return p;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Binary image, bank 0 first and each bank MEM_SIZE bytes
+// Outputs: 0 on success, -1 if it could not be mapped
+// Description: Maps the image read-only and points the pages it
+//              covers at it. Stores give a page its own copy, so the
+//              file is never written.
+// /////////////////////////////////////////////////////////////////
+int mem_map_image(const char * filename) {
+    struct stat st;			// Size of the image
+    unsigned int pages;			// Pages the image covers
+    unsigned int i;			// Count variable
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+	return -1;
+    }
+    if ((fstat(fd, &st) != 0) || ((size_t)st.st_size > mem_extent())) {
+	close(fd);
+	return -1;
+    }
+    if (st.st_size == 0) {
+	close(fd);
+	return 0;
+    }
+
+    // Bytes past the end of the file up to the host page read as zero
+    mem_image = (const unsigned char *)mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem_image == MAP_FAILED) {
+	mem_image = 0;
+	return -1;
+    }
+    mem_image_size = st.st_size;
+
+    pages = (mem_image_size + MEM_PAGE_SIZE - 1) / MEM_PAGE_SIZE;
+    for (i = 0; i < pages; i++) {
+	mem_pages[i] = mem_image + (size_t)i * MEM_PAGE_SIZE;
+    }
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: File to write
+// Outputs: 0 on success, -1 on error
+// Description: Writes all of data memory in the --data-in layout.
+//              Pages still reading the zero page are left as holes.
+//              The image is written to a new file that is then renamed
+//              over the old one, since truncating the file in place
+//              would zero pages still mapped from it by --data-in.
+// /////////////////////////////////////////////////////////////////
+int mem_write_image(const char * filename) {
+    unsigned char * image;		// Mapped output file
+    string temp;			// File written before the rename
+    size_t size;			// Bytes in the output file
+    size_t offset;			// Offset of the page
+    size_t length;			// Bytes of the page in the file
+    unsigned int i;			// Count variable
+    int fd;
+
+    size = mem_extent();
+
+    temp = string(filename) + ".XXXXXX";
+    fd = mkstemp(&temp[0]);
+    if (fd < 0) {
+	return -1;
+    }
+    if ((fchmod(fd, 0644) != 0) || (ftruncate(fd, size) != 0)) {
+	close(fd);
+	unlink(temp.c_str());
+	return -1;
+    }
+
+    image = (unsigned char *)mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) {
+	unlink(temp.c_str());
+	return -1;
+    }
+
+    for (i = 0; i < MEM_MAX_BANKS * MEM_BANK_PAGES; i++) {
+	offset = (size_t)i * MEM_PAGE_SIZE;
+	if ((offset >= size) || (mem_pages[i] == mem_zero_page)) {
+	    continue;
+	}
+	length = min((size_t)MEM_PAGE_SIZE, size - offset);
+	memcpy(image + offset, mem_pages[i], length);
+    }
+
+    munmap(image, size);
+
+    if (rename(temp.c_str(), filename) != 0) {
+	unlink(temp.c_str());
+	return -1;
+    }
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: File to write
+// Outputs: 0 on success, -1 on error
+// Description: Lists every word that differs from the start of the
+//              run, one "ADDR OLD NEW" line each in hex, with a
+//              "BANK:" prefix when there are banks. Only the pages
+//              stored to are compared.
+// /////////////////////////////////////////////////////////////////
+int mem_write_diff(const char * filename) {
+    FILE * out;				// Diff file
+    vector<unsigned int> pages;		// Pages stored to, in address order
+    size_t offset;			// Offset of the word
+    unsigned short int old_word;	// Word at the start of the run
+    unsigned short int new_word;	// Word now
+    unsigned int i, j;			// Count variables
+
+    out = fopen(filename, "w");
+    if (!out) {
+	return -1;
+    }
+
+    pages = mem_owned;
+    sort(pages.begin(), pages.end());
+
+    fprintf(out, "# ADDR OLD NEW\n");
+    for (i = 0; i < pages.size(); i++) {
+	for (j = 0; j < MEM_PAGE_SIZE; j += 2) {
+	    offset = (size_t)pages[i] * MEM_PAGE_SIZE + j;
+	    old_word = 0;
+	    if (offset < mem_image_size) {
+		old_word = mem_image[offset] << 8;
+		if (offset + 1 < mem_image_size) {
+		    old_word |= mem_image[offset + 1];
+		}
+	    }
+	    new_word = (mem_write_pages[pages[i]][j] << 8) | mem_write_pages[pages[i]][j + 1];
+	    if (old_word == new_word) {
+		continue;
+	    }
+	    if (mem_banks > 1) {
+		fprintf(out, "%u:", (unsigned int)(offset / MEM_SIZE));
+	    }
+	    fprintf(out, "%04X %04X %04X\n", (unsigned int)(offset % MEM_SIZE), old_word, new_word);
+	}
+    }
+
+    fclose(out);
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Prints how much of the address space was stored to
+// /////////////////////////////////////////////////////////////////
+void mem_report() {
+    unsigned int pages;			// Pages in the address space
+    unsigned int bank_pages[MEM_MAX_BANKS];	// Pages owned per bank
+    unsigned int i;			// Count variable
+
+    pages = mem_banks * ((mem_size + MEM_PAGE_SIZE - 1) / MEM_PAGE_SIZE);
+    memset(bank_pages, 0, sizeof(bank_pages));
+    for (i = 0; i < mem_owned.size(); i++) {
+	bank_pages[mem_owned[i] / MEM_BANK_PAGES]++;
+    }
+
+    cout << endl << "Memory Report: " << mem_banks << " x " << mem_size << " bytes in " << MEM_PAGE_SIZE << " byte pages" << endl;
+    fprintf(stdout, "  Pages touched\t%u of %u (%.2f%%)\n", (unsigned int)mem_owned.size(), pages, (100.0 * mem_owned.size()) / pages);
+    cout << "  Host memory\t" << (mem_owned.size() * MEM_PAGE_SIZE) << " bytes" << endl;
+    if (mem_image) {
+	cout << "  Image mapped\t" << mem_image_size << " bytes" << endl;
+    }
+    if (mem_banks > 1) {
+	for (i = 0; i < mem_banks; i++) {
+	    cout << "  Bank " << i << "\t\t" << bank_pages[i] << " pages" << endl;
+	}
+    }
+
+    return;
+}
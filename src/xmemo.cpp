@@ -0,0 +1,84 @@
+// //////////////////////////////////////////////////////////////////
+// File: xmemo.cpp
+// Description: A direct-mapped table remembering what register-only
+//              blocks computed. A block with no LW, SW, PUT or HALT
+//              leaves the same registers and next PC whenever it
+//              starts from the same live-in registers, so the fast
+//              engine can copy them from here instead of running it.
+//              The table size is fixed when it is opened, and a new
+//              entry simply replaces whatever shared its slot.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xmemo.h"
+#include <stdlib.h>
+
+using namespace std;
+
+__thread int memo_enabled = 0;			// Memoize pure blocks
+__thread long memo_kb = MEMO_DEFAULT_KB;		// Size of the table
+__thread struct memo_entry * memo_table = 0;	// Table of entries
+__thread unsigned long memo_mask = 0;		// Entries - 1
+__thread unsigned long long memo_lookups = 0;	// Blocks looked up
+__thread unsigned long long memo_hits = 0;		// Lookups answered by the table
+__thread unsigned long long memo_stores = 0;	// Entries written
+__thread unsigned long long memo_rejected = 0;	// Blocks no longer looked up
+
+// /////////////////////////////////////////////////////////////////
+// Outputs: 0 on success, -1 if the table could not be allocated
+// Description: Allocates the largest power of two number of entries
+//              that fits in memo_kb
+// /////////////////////////////////////////////////////////////////
+int memo_open() {
+    unsigned long entries;
+    unsigned long i;
+
+    entries = 1;
+    while (entries * 2 * sizeof(struct memo_entry) <= (unsigned long)memo_kb * 1024) {
+	entries *= 2;
+    }
+
+    memo_table = (struct memo_entry *)malloc(entries * sizeof(struct memo_entry));
+    if (!memo_table) {
+	return -1;
+    }
+
+    for (i = 0; i < entries; i++) {
+	memo_table[i].block = -1;
+    }
+    memo_mask = entries - 1;
+
+    memo_lookups = 0;
+    memo_hits = 0;
+    memo_stores = 0;
+    memo_rejected = 0;
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Frees the table
+// /////////////////////////////////////////////////////////////////
+void memo_close() {
+
+    free(memo_table);
+    memo_table = 0;
+    memo_mask = 0;
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Prints how often the table answered a lookup
+// /////////////////////////////////////////////////////////////////
+void memo_report() {
+
+    cout << endl << "Memo Report: " << (memo_mask + 1) << " entries (" << ((memo_mask + 1) * sizeof(struct memo_entry) / 1024) << " KB)" << endl;
+    cout << "  Lookups\t" << memo_lookups << endl;
+    fprintf(stdout, "  Hits\t\t%llu (%.2f%%)\n", memo_hits, memo_lookups ? (100.0 * memo_hits) / memo_lookups : 0.0);
+    cout << "  Stores\t" << memo_stores << endl;
+    cout << "  Rejected\t" << memo_rejected << " blocks" << endl;
+
+    return;
+}
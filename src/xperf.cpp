@@ -0,0 +1,203 @@
+// //////////////////////////////////////////////////////////////////
+// File: xperf.cpp
+// Description: Counter and region instructions of --perf-isa. A region
+//              keeps a copy of clock_cycles from its MARK begin and
+//              adds the change to its totals at the MARK end, so it
+//              costs nothing while it is open. Regions still open when
+//              the program stops are reported up to that point.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xperf.h"
+
+using namespace std;
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread unsigned long long clock_cycles[22];
+extern __thread int latency_vals[8];
+extern __thread short int reg_file[8];
+extern __thread unsigned short int program_counter;
+// //////////////////////////////////////////
+
+// One region of interest
+struct perf_region {
+    unsigned long long entries;		// MARK begins
+    unsigned long long counts[22];	// Stats of the closed entries
+    unsigned long long start[22];	// clock_cycles at the open entry
+    int open;				// Inside the region
+};
+
+__thread int perf_isa_enabled = 0;			// Extension enabled
+__thread int perf_marked = 0;				// A MARK ran
+static __thread struct perf_region perf_regions[PERF_REGIONS];	// Regions by number
+
+// /////////////////////////////////////////////////////////////////
+// Description: Forgets every region, called with reset_state()
+// /////////////////////////////////////////////////////////////////
+void perf_reset() {
+
+    if (perf_marked) {
+	memset(perf_regions, 0, sizeof(perf_regions));
+	perf_marked = 0;
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: One 5-bit opcode
+// Outputs: Non-zero if it is an extension instruction and they are
+//          enabled
+// /////////////////////////////////////////////////////////////////
+int perf_opcode(unsigned short int opcode) {
+
+    return perf_isa_enabled && ((opcode == 0x0A) || (opcode == 0x0B) || (opcode == 0x0F) || (opcode == 0x19));
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Stats counters
+// Outputs: Instructions and cycles they add up to, as count_totals
+// /////////////////////////////////////////////////////////////////
+static void perf_totals(const unsigned long long * counts, unsigned long long * inst_count, unsigned long long * num_cycles) {
+    int i;
+
+    *inst_count = 0;
+    *num_cycles = 0;
+    for (i = 0; i < 22; i++) {
+	*inst_count += counts[i];
+	*num_cycles += counts[i] * ((i < 8) ? latency_vals[i] : 1);
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Instruction, count it reads, which 16 bits of it and the
+//         name to trace
+// Outputs: The next PC
+// /////////////////////////////////////////////////////////////////
+static short int perf_read(short int inst, unsigned long long value, int word, const char * name) {
+    short int rd = (inst >> 8) & 0x0007;	// Destination register
+
+    reg_file[rd] = (short int)(value >> (16 * word));
+    trace_inst(name);
+
+    return (unsigned short int) (program_counter + 2);
+}
+
+short int x_rdcyc(short int inst) {
+    unsigned long long inst_count;
+    unsigned long long num_cycles;
+
+    perf_totals(clock_cycles, &inst_count, &num_cycles);
+
+    return perf_read(inst, num_cycles, inst & 0x0003, "RDCYC");
+}
+
+short int x_rdinst(short int inst) {
+    unsigned long long inst_count;
+    unsigned long long num_cycles;
+
+    perf_totals(clock_cycles, &inst_count, &num_cycles);
+
+    return perf_read(inst, inst_count, inst & 0x0003, "RDINST");
+}
+
+// Events past the last counter read as 0
+short int x_rdevt(short int inst) {
+    int event = inst & 0x001F;		// Instruction_Name
+
+    return perf_read(inst, (event < 22) ? clock_cycles[event] : 0, (inst >> 5) & 0x0003, "RDEVT");
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: A begin inside the region first ends the entry that
+//              is open, an end outside it does nothing
+// /////////////////////////////////////////////////////////////////
+short int x_mark(short int inst) {
+    struct perf_region * region = &perf_regions[inst & 0x001F];
+    int i;
+
+    perf_marked = 1;
+
+    if (region->open) {
+	for (i = 0; i < 22; i++) {
+	    region->counts[i] += clock_cycles[i] - region->start[i];
+	}
+	region->open = 0;
+    }
+    if (!(inst & 0x0080)) {
+	memcpy(region->start, clock_cycles, sizeof(region->start));
+	region->open = 1;
+	region->entries++;
+    }
+
+    trace_inst("MARK");
+
+    return (unsigned short int) (program_counter + 2);
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Instruction and its opcode, one perf_opcode() accepts
+// Outputs: The next PC
+// /////////////////////////////////////////////////////////////////
+short int perf_execute(short int inst, unsigned short int opcode) {
+
+    switch (opcode) {
+	case (0x0A):
+	    return x_rdcyc(inst);
+	case (0x0B):
+	    return x_rdinst(inst);
+	case (0x0F):
+	    return x_rdevt(inst);
+	default:
+	    return x_mark(inst);
+    }
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Output stats object
+// Description: Adds a "regions" array with the stats of every region
+//              entered, when the program marked any
+// /////////////////////////////////////////////////////////////////
+void perf_write(Json::Value & array) {
+    Json::Value regions(Json::arrayValue);	// Regions entered
+    Json::Value obj;				// One of them
+    unsigned long long counts[22];		// Its stats
+    unsigned long long inst_count;
+    unsigned long long num_cycles;
+    int r, i;
+
+    if (!perf_marked) {
+	return;
+    }
+
+    for (r = 0; r < PERF_REGIONS; r++) {
+	if (!perf_regions[r].entries) {
+	    continue;
+	}
+	for (i = 0; i < 22; i++) {
+	    counts[i] = perf_regions[r].counts[i];
+	    if (perf_regions[r].open) {
+		counts[i] += clock_cycles[i] - perf_regions[r].start[i];
+	    }
+	}
+	perf_totals(counts, &inst_count, &num_cycles);
+
+	obj.clear();
+	obj["id"] = r;
+	obj["entries"] = (Json::UInt64)perf_regions[r].entries;
+	for (i = 0; i < 22; i++) {
+	    obj[stat_names[i]] = (Json::UInt64)counts[i];
+	}
+	obj["instructions"] = (Json::UInt64)inst_count;
+	obj["cycles"] = (Json::UInt64)num_cycles;
+	regions.append(obj);
+    }
+
+    array["regions"] = regions;
+
+    return;
+}
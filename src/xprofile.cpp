@@ -0,0 +1,268 @@
+// //////////////////////////////////////////////////////////////////
+// File: xprofile.cpp
+// Description: Counts executions and latency weighted cycles for every
+//              instruction address. Counters are flat arrays indexed by
+//              PC/2. Basic blocks are rebuilt from the counters at exit,
+//              and call paths are followed with a shadow stack driven by
+//              JALR and JR.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xprofile.h"
+#include <vector>
+#include <map>
+#include <string>
+
+using namespace std;
+
+// Deepest call path that is recorded, deeper calls are folded into it
+#define MAX_CALL_DEPTH 256
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread int latency_vals[8];
+// //////////////////////////////////////////
+
+// One node of the call tree
+struct call_node {
+    int parent;				// Index of calling node
+    unsigned short int entry;		// Address the call jumped to
+    unsigned long long count;		// Instructions executed in this node
+    unsigned long long cycles;		// Cycles spent in this node
+};
+
+int profile_enabled = 0;				// Profiling flag
+
+unsigned long long pc_count[MEM_SIZE/2];		// Executions per instruction
+unsigned long long pc_cycles[MEM_SIZE/2];		// Cycles per instruction
+unsigned char pc_leader[MEM_SIZE/2];			// Instruction starts a block
+
+vector<call_node> call_tree;				// Call tree, node 0 is main
+map<pair<int, unsigned short int>, int> call_children;	// (parent, entry) to node
+int call_current;					// Node currently executing
+int call_tree_depth;						// Depth of call_current
+int call_overflow;					// Calls past MAX_CALL_DEPTH
+
+// /////////////////////////////////////////////////////////////////
+// Description: Clear all counters before a new run
+// /////////////////////////////////////////////////////////////////
+void profile_reset() {
+    call_node root;
+
+    memset(pc_count, 0, sizeof(pc_count));
+    memset(pc_cycles, 0, sizeof(pc_cycles));
+    memset(pc_leader, 0, sizeof(pc_leader));
+
+    // Program entry always starts a block
+    pc_leader[0] = 1;
+
+    root.parent = -1;
+    root.entry = 0;
+    root.count = 0;
+    root.cycles = 0;
+
+    call_tree.clear();
+    call_children.clear();
+    call_tree.push_back(root);
+    call_current = 0;
+    call_tree_depth = 0;
+    call_overflow = 0;
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Address and value of the instruction that just executed, and
+//         the program counter it produced
+// Description: Updates the flat counters and the shadow call stack
+// /////////////////////////////////////////////////////////////////
+void profile_update(unsigned short int pc, unsigned short int inst, unsigned short int next_pc) {
+    unsigned short int op;		// Opcode
+    int name;				// Instruction_Name of the opcode
+    int cycles;				// Weighted cost of the instruction
+    int child;				// Call tree node being entered
+    call_node node;			// New call tree node
+    map<pair<int, unsigned short int>, int>::iterator it;
+
+    // Instructions that terminated the program with an error are not counted
+    if (next_pc == (unsigned short int)-1) {
+	return;
+    }
+
+    get_opcode(inst, &op);
+
+    // Invalid opcodes are not part of the stats
+    name = get_inst_name(op);
+    if (name < 0) {
+	return;
+    }
+
+    // Arithmetic uses the configured latency, everything else is 1 cycle
+    cycles = (name < 8) ? latency_vals[name] : 1;
+
+    pc_count[pc >> 1] += 1;
+    pc_cycles[pc >> 1] += cycles;
+
+    call_tree[call_current].count += 1;
+    call_tree[call_current].cycles += cycles;
+
+    // Any change of flow starts new blocks at the target and fall through
+    if (((op >= 0x13) && (op <= 0x18)) || (op == 0x0C)) {
+	pc_leader[next_pc >> 1] = 1;
+	pc_leader[((unsigned short int)(pc + 2)) >> 1] = 1;
+    }
+
+    // JALR enters a callee
+    if (op == 0x13) {
+	if (call_tree_depth >= MAX_CALL_DEPTH) {
+	    call_overflow++;
+	}
+	else {
+	    it = call_children.find(make_pair(call_current, next_pc));
+	    if (it == call_children.end()) {
+		node.parent = call_current;
+		node.entry = next_pc;
+		node.count = 0;
+		node.cycles = 0;
+		child = call_tree.size();
+		call_tree.push_back(node);
+		call_children[make_pair(call_current, next_pc)] = child;
+	    }
+	    else {
+		child = it->second;
+	    }
+	    call_current = child;
+	    call_tree_depth++;
+	}
+    }
+    // JR returns to the caller
+    else if (op == 0x0C) {
+	if (call_overflow > 0) {
+	    call_overflow--;
+	}
+	else if (call_tree_depth > 0) {
+	    call_current = call_tree[call_current].parent;
+	    call_tree_depth--;
+	}
+    }
+
+    return;
+}
+
+// Name of one call tree node as used in reports
+static string frame_name(int node) {
+    char name[16];
+
+    if (node == 0) {
+	return string("main");
+    }
+
+    snprintf(name, sizeof(name), "0x%04x", call_tree[node].entry);
+
+    return string(name);
+}
+
+// Full call path of one node, outermost first, separated by ';'
+static string frame_path(int node) {
+    string path;
+
+    path = frame_name(node);
+    while (call_tree[node].parent >= 0) {
+	node = call_tree[node].parent;
+	path = frame_name(node) + ";" + path;
+    }
+
+    return path;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Base name for the report files
+// Description: Writes <basename>.profile.json with per-PC, per-block and
+//              per-call-path counts, and <basename>.folded with one line
+//              per call path for flame graph tools
+// /////////////////////////////////////////////////////////////////
+void profile_write(const char * basename) {
+    ofstream outfile;
+    Json::Value root;
+    Json::Value pc_array(Json::arrayValue);
+    Json::Value block_array(Json::arrayValue);
+    Json::Value path_array(Json::arrayValue);
+    Json::Value obj;
+    Json::StyledWriter styledWriter;
+    string filename;
+    int i;
+    int start;				// First index of the current block
+    unsigned long long block_insts;	// Instructions executed in the block
+    unsigned long long block_cycles;	// Cycles spent in the block
+
+    // Per-PC counts
+    for (i = 0; i < (MEM_SIZE/2); i++) {
+	if (pc_count[i] == 0) {
+	    continue;
+	}
+	obj.clear();
+	obj["pc"] = i << 1;
+	obj["count"] = (Json::UInt64)pc_count[i];
+	obj["cycles"] = (Json::UInt64)pc_cycles[i];
+	pc_array.append(obj);
+    }
+
+    // Basic blocks are runs of executed instructions between leaders
+    start = -1;
+    block_insts = 0;
+    block_cycles = 0;
+    for (i = 0; i <= (MEM_SIZE/2); i++) {
+	if ((start >= 0) && ((i == (MEM_SIZE/2)) || (pc_count[i] == 0) || pc_leader[i])) {
+	    obj.clear();
+	    obj["start"] = start << 1;
+	    obj["end"] = (i - 1) << 1;
+	    obj["count"] = (Json::UInt64)pc_count[start];
+	    obj["instructions"] = (Json::UInt64)block_insts;
+	    obj["cycles"] = (Json::UInt64)block_cycles;
+	    block_array.append(obj);
+	    start = -1;
+	}
+	if ((i == (MEM_SIZE/2)) || (pc_count[i] == 0)) {
+	    continue;
+	}
+	if (start < 0) {
+	    start = i;
+	    block_insts = 0;
+	    block_cycles = 0;
+	}
+	block_insts += pc_count[i];
+	block_cycles += pc_cycles[i];
+    }
+
+    // Call paths
+    for (i = 0; i < (int)call_tree.size(); i++) {
+	obj.clear();
+	obj["path"] = frame_path(i);
+	obj["entry"] = call_tree[i].entry;
+	obj["count"] = (Json::UInt64)call_tree[i].count;
+	obj["cycles"] = (Json::UInt64)call_tree[i].cycles;
+	path_array.append(obj);
+    }
+
+    root["instructions"] = pc_array;
+    root["blocks"] = block_array;
+    root["call_paths"] = path_array;
+
+    filename = string(basename) + ".profile.json";
+    outfile.open(filename.c_str());
+    outfile << styledWriter.write(root);
+    outfile.close();
+
+    // Folded stacks weighted by cycles
+    filename = string(basename) + ".folded";
+    outfile.open(filename.c_str());
+    for (i = 0; i < (int)call_tree.size(); i++) {
+	if (call_tree[i].cycles > 0) {
+	    outfile << frame_path(i) << " " << call_tree[i].cycles << "\n";
+	}
+    }
+    outfile.close();
+
+    return;
+}
@@ -0,0 +1,318 @@
+// //////////////////////////////////////////////////////////////////
+// File: xresults.cpp
+// Description: Appends the registers and stats of the run that just
+//              ended to a columnar results file (see xresults.h). The
+//              header and the row group being filled are mapped, so an
+//              append is a lock, a few stores and an unlock; nothing is
+//              formatted or allocated once the names are in the
+//              dictionary.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xresults.h"
+#include "xcore.h"
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread unsigned long long clock_cycles[22];
+extern __thread short int reg_file[8];
+extern __thread unsigned short int program_counter;
+// //////////////////////////////////////////
+
+// Bytes of a value of each Results_Type
+static const unsigned int results_width[6] = {0, 8, 4, 4, 2, 2};
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Header to fill in
+// Description: The layout every results file has, with no rows
+// /////////////////////////////////////////////////////////////////
+static void results_layout(struct results_header * header) {
+    static const char * register_names[8] = {"r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7"};
+    unsigned long long offset;		// Where the next column starts
+    int i;
+
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, RESULTS_MAGIC, sizeof(RESULTS_MAGIC));
+    header->version = RESULTS_VERSION;
+    header->columns = RESULTS_COLUMNS;
+    header->group_rows = RESULTS_GROUP_ROWS;
+    header->header_size = RESULTS_HEADER_SIZE;
+    header->endian = RESULTS_ENDIAN;
+
+    // Widest first, so every array is aligned to its width
+    for (i = 0; i < 22; i++) {
+	strcpy(header->column[i].name, stat_names[i]);
+	header->column[i].type = RESULTS_U64;
+    }
+    strcpy(header->column[22].name, "instructions");
+    header->column[22].type = RESULTS_U64;
+    strcpy(header->column[23].name, "cycles");
+    header->column[23].type = RESULTS_U64;
+    strcpy(header->column[24].name, "program");
+    header->column[24].type = RESULTS_U32;
+    strcpy(header->column[25].name, "config");
+    header->column[25].type = RESULTS_U32;
+    strcpy(header->column[26].name, "exit");
+    header->column[26].type = RESULTS_I32;
+    strcpy(header->column[27].name, "pc");
+    header->column[27].type = RESULTS_U16;
+    for (i = 0; i < 8; i++) {
+	strcpy(header->column[28 + i].name, register_names[i]);
+	header->column[28 + i].type = RESULTS_I16;
+    }
+
+    offset = 0;
+    for (i = 0; i < RESULTS_COLUMNS; i++) {
+	header->column[i].offset = offset;
+	offset += (unsigned long long)results_width[header->column[i].type] * RESULTS_GROUP_ROWS;
+    }
+    header->group_bytes = offset;
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Reads the names other writers added to the dictionary
+// /////////////////////////////////////////////////////////////////
+static void results_read_dict(struct results_file * results) {
+    struct stat st;
+    string text;			// Lines not read yet
+    size_t start, end;
+
+    if ((fstat(results->dict_fd, &st) != 0) || (st.st_size <= results->dict_size)) {
+	return;
+    }
+
+    text.resize(st.st_size - results->dict_size);
+    if (pread(results->dict_fd, &text[0], text.size(), results->dict_size) != (ssize_t)text.size()) {
+	return;
+    }
+
+    // Only whole lines
+    for (start = 0; (end = text.find('\n', start)) != string::npos; start = end + 1) {
+	results->ids.insert(make_pair(text.substr(start, end - start), (unsigned int)results->ids.size()));
+    }
+    results->dict_size += start;
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Program or configuration name, with the file locked
+// Outputs: Its line in the dictionary, added if it is new
+// /////////////////////////////////////////////////////////////////
+static unsigned int results_id(struct results_file * results, const char * name) {
+    map<string, unsigned int>::iterator found;
+    string line(name ? name : "");
+    unsigned int id;
+    size_t i;
+
+    for (i = 0; i < line.size(); i++) {
+	if (line[i] == '\n') {
+	    line[i] = ' ';
+	}
+    }
+
+    found = results->ids.find(line);
+    if (found != results->ids.end()) {
+	return found->second;
+    }
+    results_read_dict(results);
+    found = results->ids.find(line);
+    if (found != results->ids.end()) {
+	return found->second;
+    }
+
+    id = results->ids.size();
+    results->ids[line] = id;
+    line += '\n';
+    if (write(results->dict_fd, line.data(), line.size()) == (ssize_t)line.size()) {
+	results->dict_size += line.size();
+    }
+
+    return id;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Results file to fill in, file name
+// Outputs: 0 on success, -1 if the file could not be created or has
+//          another layout
+// Description: Creates the file with no rows if it does not exist
+// /////////////////////////////////////////////////////////////////
+int results_open(struct results_file * results, const char * filename) {
+    struct results_header layout;	// Header of a new file
+    struct results_header found;	// Header of the file, rows cleared
+    struct stat st;
+    string dictname;
+    void * map;
+    int error;
+
+    results->fd = -1;
+    results->dict_fd = -1;
+    results->dict_size = 0;
+    results->ids.clear();
+    results->header = 0;
+    results->group = 0;
+    results->group_index = 0;
+
+    results_layout(&layout);
+
+    results->fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if (results->fd < 0) {
+	return -1;
+    }
+
+    flock(results->fd, LOCK_EX);
+    error = (fstat(results->fd, &st) != 0);
+    if (!error && (st.st_size == 0)) {
+	error = (ftruncate(results->fd, RESULTS_HEADER_SIZE) != 0) ||
+		(pwrite(results->fd, &layout, sizeof(layout), 0) != (ssize_t)sizeof(layout));
+    }
+    else if (!error) {
+	error = (st.st_size < RESULTS_HEADER_SIZE);
+    }
+    if (!error) {
+	map = mmap(0, RESULTS_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, results->fd, 0);
+	error = (map == MAP_FAILED);
+	if (!error) {
+	    results->header = (struct results_header *)map;
+	    memcpy(&found, results->header, sizeof(found));
+	    found.rows = 0;
+	    error = (memcmp(&found, &layout, sizeof(layout)) != 0);
+	}
+    }
+    flock(results->fd, LOCK_UN);
+
+    if (!error) {
+	dictname = string(filename) + ".dict";
+	results->dict_fd = open(dictname.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+	error = (results->dict_fd < 0);
+    }
+    if (error) {
+	results_close(results);
+	return -1;
+    }
+
+    results_read_dict(results);
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Open results file, program and configuration names, exit
+//         code of the run
+// Outputs: 0 on success, -1 if the file could not be grown
+// Description: Appends the registers, PC and stats counters of the
+//              calling thread's simulator
+// /////////////////////////////////////////////////////////////////
+int results_append(struct results_file * results, const char * program, const char * config, int exit_code) {
+    struct results_header * header;	// Mapped header
+    unsigned long long values[RESULTS_COLUMNS];	// The row
+    unsigned long long row;		// Its number
+    unsigned long long group;		// Group it goes into
+    unsigned long long length;		// Bytes the file needs
+    unsigned int slot;			// Row within the group
+    struct stat st;
+    void * map;
+    char * column;
+    int i;
+
+    if (!results->header) {
+	return -1;
+    }
+    header = results->header;
+
+    memcpy(values, clock_cycles, sizeof(clock_cycles));
+    count_totals(&values[22], &values[23]);
+
+    flock(results->fd, LOCK_EX);
+
+    values[24] = results_id(results, program);
+    values[25] = results_id(results, config);
+    values[26] = (unsigned int)exit_code;
+    values[27] = program_counter;
+    for (i = 0; i < 8; i++) {
+	values[28 + i] = (unsigned short int)reg_file[i];
+    }
+
+    row = header->rows;
+    group = row / RESULTS_GROUP_ROWS;
+    slot = row % RESULTS_GROUP_ROWS;
+
+    // Map the group, growing the file when a new one starts
+    if (!results->group || (results->group_index != group)) {
+	if (results->group) {
+	    munmap(results->group, header->group_bytes);
+	    results->group = 0;
+	}
+	length = RESULTS_HEADER_SIZE + (group + 1) * header->group_bytes;
+	if ((fstat(results->fd, &st) != 0) ||
+	    (((unsigned long long)st.st_size < length) && (ftruncate(results->fd, length) != 0))) {
+	    flock(results->fd, LOCK_UN);
+	    return -1;
+	}
+	map = mmap(0, header->group_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, results->fd,
+		   RESULTS_HEADER_SIZE + group * header->group_bytes);
+	if (map == MAP_FAILED) {
+	    flock(results->fd, LOCK_UN);
+	    return -1;
+	}
+	results->group = (char *)map;
+	results->group_index = group;
+    }
+
+    for (i = 0; i < RESULTS_COLUMNS; i++) {
+	column = results->group + header->column[i].offset;
+	switch (header->column[i].type) {
+	    case RESULTS_U64:
+		((unsigned long long *)column)[slot] = values[i];
+		break;
+	    case RESULTS_U32:
+	    case RESULTS_I32:
+		((unsigned int *)column)[slot] = values[i];
+		break;
+	    default:
+		((unsigned short int *)column)[slot] = values[i];
+		break;
+	}
+    }
+
+    // The row is complete before readers count it
+    __sync_synchronize();
+    header->rows = row + 1;
+
+    flock(results->fd, LOCK_UN);
+
+    return 0;
+}
+
+void results_close(struct results_file * results) {
+
+    if (results->group) {
+	munmap(results->group, results->header->group_bytes);
+	results->group = 0;
+    }
+    if (results->header) {
+	munmap(results->header, RESULTS_HEADER_SIZE);
+	results->header = 0;
+    }
+    if (results->dict_fd >= 0) {
+	close(results->dict_fd);
+	results->dict_fd = -1;
+    }
+    if (results->fd >= 0) {
+	close(results->fd);
+	results->fd = -1;
+    }
+    results->ids.clear();
+
+    return;
+}
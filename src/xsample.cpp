@@ -0,0 +1,160 @@
+// //////////////////////////////////////////////////////////////////
+// File: xsample.cpp
+// Description: A SIGPROF interval timer periodically records the guest
+//              program counter and call depth into a fixed buffer. The
+//              signal handler is the only writer and the report is only
+//              built after the timer is stopped, so no locking is needed.
+//              Only run_engine<sample_tool> publishes the PC and depth
+//              the handler reads, other runs do not pay for them.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xsample.h"
+#include <sys/time.h>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// Number of samples kept, later samples are only counted
+#define SAMPLE_BUFFER_SIZE (1 << 20)
+// Number of hot spots listed in the report
+#define SAMPLE_REPORT_TOP 20
+
+int sample_enabled = 0;					// Sampling flag
+long sample_interval_usec = SAMPLE_DEFAULT_USEC;	// Sampling period
+
+unsigned int sample_buffer[SAMPLE_BUFFER_SIZE];		// PC and depth per sample
+volatile sig_atomic_t sample_count = 0;			// Samples in buffer
+volatile sig_atomic_t sample_dropped = 0;		// Samples past the buffer
+volatile sig_atomic_t sample_pc = 0;			// Guest PC being executed
+volatile sig_atomic_t sample_depth = 0;			// JALR calls not yet returned from
+
+// /////////////////////////////////////////////////////////////////
+// Description: SIGPROF handler, packs depth in the high half and the
+//              program counter in the low half of one word
+// /////////////////////////////////////////////////////////////////
+static void sample_handler(int signum) {
+    unsigned int depth;
+
+    if (sample_count >= SAMPLE_BUFFER_SIZE) {
+	sample_dropped = sample_dropped + 1;
+	return;
+    }
+
+    depth = (sample_depth > 0xFFFF) ? 0xFFFF : sample_depth;
+    sample_buffer[sample_count] = (depth << 16) | (sample_pc & 0xFFFF);
+    sample_count = sample_count + 1;
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Outputs: 0 on success, -1 if the timer could not be armed
+// Description: Installs the handler and arms the CPU time interval timer
+// /////////////////////////////////////////////////////////////////
+int sample_start() {
+    struct sigaction action;
+    struct itimerval timer;
+
+    sample_count = 0;
+    sample_dropped = 0;
+    sample_pc = 0;
+    sample_depth = 0;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = sample_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    if (sigaction(SIGPROF, &action, 0) != 0) {
+	return -1;
+    }
+
+    timer.it_interval.tv_sec = sample_interval_usec / 1000000;
+    timer.it_interval.tv_usec = sample_interval_usec % 1000000;
+    timer.it_value = timer.it_interval;
+
+    if (setitimer(ITIMER_PROF, &timer, 0) != 0) {
+	return -1;
+    }
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Disarms the timer and restores the default handler
+// /////////////////////////////////////////////////////////////////
+void sample_stop() {
+    struct itimerval timer;
+
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, 0);
+    signal(SIGPROF, SIG_DFL);
+
+    return;
+}
+
+// Sort hot spots by descending sample count
+static bool hotter(const pair<unsigned int, unsigned short int> & a, const pair<unsigned int, unsigned short int> & b) {
+    if (a.first != b.first) {
+	return a.first > b.first;
+    }
+    return a.second < b.second;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Prints the hottest program counters and the call depth
+//              distribution of all recorded samples
+// /////////////////////////////////////////////////////////////////
+void sample_report() {
+    vector<unsigned int> pc_hits(MEM_SIZE/2, 0);	// Samples per instruction
+    vector<unsigned int> depth_hits;			// Samples per call depth
+    vector<pair<unsigned int, unsigned short int> > hot;
+    unsigned int depth;
+    long total;
+    long i;
+
+    total = sample_count;
+
+    for (i = 0; i < total; i++) {
+	pc_hits[(sample_buffer[i] & 0xFFFF) >> 1]++;
+	depth = sample_buffer[i] >> 16;
+	if (depth >= depth_hits.size()) {
+	    depth_hits.resize(depth + 1, 0);
+	}
+	depth_hits[depth]++;
+    }
+
+    for (i = 0; i < (MEM_SIZE/2); i++) {
+	if (pc_hits[i] > 0) {
+	    hot.push_back(make_pair(pc_hits[i], (unsigned short int)(i << 1)));
+	}
+    }
+    sort(hot.begin(), hot.end(), hotter);
+
+    cout << endl << "Sample Report: " << total << " samples every " << sample_interval_usec << " us";
+    if (sample_dropped > 0) {
+	cout << " (" << sample_dropped << " dropped)";
+    }
+    cout << endl;
+
+    if (total == 0) {
+	return;
+    }
+
+    cout << "  PC\tSamples\tPercent" << endl;
+    for (i = 0; (i < (long)hot.size()) && (i < SAMPLE_REPORT_TOP); i++) {
+	fprintf(stdout, "  0x%04x\t%u\t%.2f%%\n", hot[i].second, hot[i].first, (100.0 * hot[i].first) / total);
+    }
+
+    cout << "  Depth\tSamples\tPercent" << endl;
+    for (i = 0; i < (long)depth_hits.size(); i++) {
+	if (depth_hits[i] > 0) {
+	    fprintf(stdout, "  %ld\t%u\t%.2f%%\n", i, depth_hits[i], (100.0 * depth_hits[i]) / total);
+	}
+    }
+
+    return;
+}
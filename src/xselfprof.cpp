@@ -0,0 +1,229 @@
+// //////////////////////////////////////////////////////////////////
+// File: xselfprof.cpp
+// Description: Measures where the simulator spends host time. Whole
+//              phases (loading, read_config, execution, write_output)
+//              are timed with the monotonic clock and, when the kernel
+//              allows it, a perf_event cycle counter. Inside execution
+//              the time stamp counter is charged to the current bucket
+//              (one x_* handler, dispatch or trace output) each time the
+//              bucket changes, and scaled to nanoseconds and cycles with
+//              the execution phase totals.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xselfprof.h"
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread unsigned long long clock_cycles[22];
+// //////////////////////////////////////////
+
+int selfprof_enabled = 0;				// Self profiling flag
+int selfprof_buckets = 1;				// Report the per-handler buckets
+
+int perf_fd = -1;					// Cycle counter, -1 if unavailable
+unsigned long long phase_ns[SP_NUM_PHASES];		// Nanoseconds per phase
+unsigned long long phase_cycles[SP_NUM_PHASES];		// Host cycles per phase
+unsigned long long phase_start_ns[SP_NUM_PHASES];
+unsigned long long phase_start_cycles[SP_NUM_PHASES];
+unsigned long long phase_start_ticks;			// Ticks when execution began
+unsigned long long exec_ticks;				// Ticks spent executing
+
+unsigned long long bucket_ticks[SP_NUM_BUCKETS];	// Ticks per bucket
+int bucket_current;					// Bucket being charged
+unsigned long long bucket_since;			// Tick of last switch
+
+// Names printed for the buckets past the stat counters
+static const char * bucket_names[SP_NUM_BUCKETS - SP_INVALID] = {
+    "invalid", "dispatch", "trace"
+};
+
+// Names printed for each phase
+static const char * phase_names[SP_NUM_PHASES] = {
+    "load", "read_config", "execute", "write_output"
+};
+
+// Monotonic clock in nanoseconds
+static unsigned long long now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Time stamp counter, or nanoseconds where there is none
+static inline unsigned long long now_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return now_ns();
+#endif
+}
+
+// Host cycles from the perf counter, or the time stamp counter
+static unsigned long long now_cycles() {
+    unsigned long long count;
+
+    if ((perf_fd >= 0) && (read(perf_fd, &count, sizeof(count)) == sizeof(count))) {
+	return count;
+    }
+
+    return now_ticks();
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Opens the hardware cycle counter and clears all totals
+// /////////////////////////////////////////////////////////////////
+void selfprof_init() {
+    struct perf_event_attr attr;
+
+    memset(phase_ns, 0, sizeof(phase_ns));
+    memset(phase_cycles, 0, sizeof(phase_cycles));
+    memset(bucket_ticks, 0, sizeof(bucket_ticks));
+    exec_ticks = 0;
+    bucket_current = SP_DISPATCH;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+
+    // Count kernel time too (trace output is mostly system calls) if allowed
+    perf_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (perf_fd < 0) {
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	perf_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: One SelfProf_Phase
+// Description: Marks the start of a phase
+// /////////////////////////////////////////////////////////////////
+void selfprof_phase_begin(int phase) {
+
+    phase_start_ns[phase] = now_ns();
+    phase_start_cycles[phase] = now_cycles();
+
+    if (phase == SP_EXEC) {
+	phase_start_ticks = now_ticks();
+	bucket_since = phase_start_ticks;
+	bucket_current = SP_DISPATCH;
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: One SelfProf_Phase
+// Description: Adds the time since selfprof_phase_begin to the phase
+// /////////////////////////////////////////////////////////////////
+void selfprof_phase_end(int phase) {
+
+    if (phase == SP_EXEC) {
+	selfprof_switch(SP_DISPATCH);
+	exec_ticks += now_ticks() - phase_start_ticks;
+    }
+
+    phase_cycles[phase] += now_cycles() - phase_start_cycles[phase];
+    phase_ns[phase] += now_ns() - phase_start_ns[phase];
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Bucket to charge from now on
+// Outputs: Bucket that was being charged
+// Description: Charges the ticks since the last switch to the current
+//              bucket and makes the new one current
+// /////////////////////////////////////////////////////////////////
+int selfprof_switch(int bucket) {
+    unsigned long long ticks;
+    int previous;
+
+    ticks = now_ticks();
+    bucket_ticks[bucket_current] += ticks - bucket_since;
+    bucket_since = ticks;
+
+    previous = bucket_current;
+    bucket_current = bucket;
+
+    return previous;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Prints guest MIPS, the phase breakdown and the host cost
+//              of each bucket, unless the engine had no buckets
+// /////////////////////////////////////////////////////////////////
+void selfprof_report() {
+    unsigned long long inst_count;	// Guest instructions executed
+    unsigned long long total_ns;	// All phases
+    double ns_per_tick;			// Scale from ticks to nanoseconds
+    double cycles_per_tick;		// Scale from ticks to host cycles
+    double ns;
+    double cycles;
+    unsigned long long count;
+    int i;
+
+    inst_count = 0;
+    for (i = 0; i < 22; i++) {
+	inst_count += clock_cycles[i];
+    }
+
+    total_ns = 0;
+    for (i = 0; i < SP_NUM_PHASES; i++) {
+	total_ns += phase_ns[i];
+    }
+
+    ns_per_tick = (exec_ticks > 0) ? ((double)phase_ns[SP_EXEC] / exec_ticks) : 0.0;
+    cycles_per_tick = (exec_ticks > 0) ? ((double)phase_cycles[SP_EXEC] / exec_ticks) : 0.0;
+
+    cout << endl << "Self Profile (" << ((perf_fd >= 0) ? "perf_event" : "TSC") << " cycles)" << endl;
+    fprintf(stdout, "  Guest instructions: %llu\n", inst_count);
+    fprintf(stdout, "  Guest MIPS: %.3f\n", (phase_ns[SP_EXEC] > 0) ? ((double)inst_count * 1000.0 / phase_ns[SP_EXEC]) : 0.0);
+
+    cout << "  Phase\t\tns\t\tcycles\t\tpercent" << endl;
+    for (i = 0; i < SP_NUM_PHASES; i++) {
+	fprintf(stdout, "  %-12s\t%-12llu\t%-12llu\t%.2f%%\n", phase_names[i], phase_ns[i], phase_cycles[i],
+		(total_ns > 0) ? (100.0 * phase_ns[i] / total_ns) : 0.0);
+    }
+
+    if (!selfprof_buckets) {
+	cout << "  No per-handler buckets with the fast engine" << endl;
+    }
+    else {
+	cout << "  Bucket\tcount\t\tns\t\tcycles\t\tns/inst\t\tpercent" << endl;
+    }
+    for (i = 0; (i < SP_NUM_BUCKETS) && selfprof_buckets; i++) {
+	if (bucket_ticks[i] == 0) {
+	    continue;
+	}
+	ns = bucket_ticks[i] * ns_per_tick;
+	cycles = bucket_ticks[i] * cycles_per_tick;
+	count = (i < 22) ? clock_cycles[i] : inst_count;
+	fprintf(stdout, "  %-8s\t%-12llu\t%-12.0f\t%-12.0f\t%-12.2f\t%.2f%%\n", (i < 22) ? stat_names[i] : bucket_names[i - SP_INVALID], count, ns, cycles,
+		(count > 0) ? (ns / count) : 0.0, (exec_ticks > 0) ? (100.0 * bucket_ticks[i] / exec_ticks) : 0.0);
+    }
+
+    if (perf_fd >= 0) {
+	close(perf_fd);
+	perf_fd = -1;
+    }
+
+    return;
+}
@@ -0,0 +1,698 @@
+// //////////////////////////////////////////////////////////////////
+// File: xserve.cpp
+// Description: xsim --serve. One thread accepts connections on a Unix
+//              domain socket and polls all of them. Each complete
+//              request line is queued for a fixed pool of worker
+//              threads, one line per connection at a time so answers
+//              keep their order. A worker runs the request on its own
+//              copy of the simulator state (the core globals are
+//              __thread) and answers with one line. Idle connections
+//              hold no worker. When the queue is full the polling
+//              thread stops reading and accepting, so further requests
+//              wait in socket buffers and the listen backlog instead
+//              of piling up in memory. Every run is limited by the
+//              daemon's limits, which a request may only lower.
+//              Programs and configuration files are parsed once and
+//              kept until the file changes on disk.
+//
+//              Request:  {"program": FILE or "program_text": HEX,
+//                         "config": FILE or {latencies},
+//                         "options": {"engine", "memoize",
+//                         "max_instructions", "max_seconds",
+//                         "mem_size", "mem_banks", "data_in",
+//                         "results", "perf_isa"}}
+//              Response: {"exit": CODE, "output": GUEST OUTPUT,
+//                         "result": OUTPUT FILE} or {"error": TEXT}
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xserve.h"
+#include "xcore.h"
+#include "xengine.h"
+#include "xfast.h"
+#include "xblock.h"
+#include "xmemo.h"
+#include "xmem.h"
+#include "xresults.h"
+#include "xperf.h"
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sstream>
+#include <map>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// A parsed program or configuration file
+struct serve_file {
+    time_t mtime;			// Modification time when parsed
+    long mtime_nsec;
+    off_t size;				// Size when parsed
+    unsigned long long used;		// cache_clock of the last use
+    vector<unsigned char> program;	// Instruction memory of a program
+    int latency[8];			// Latencies of a configuration
+};
+
+typedef map<string, shared_ptr<const serve_file> > serve_cache;
+
+static serve_cache cached_programs;	// Programs by file name
+static serve_cache cached_configs;	// Configurations by file name
+static unsigned long long cache_clock;	// Lookups so far
+static mutex cache_lock;		// Guards both caches
+
+// One client connection. Only the polling thread touches buffer and
+// eof; busy, closing and last are guarded by pending_lock.
+struct serve_conn {
+    int fd;				// Connected socket
+    string buffer;			// Bytes received, not yet queued
+    int eof;				// The client sent all it will send
+    int busy;				// A request of it is queued or running
+    int closing;			// An answer could not be sent
+    time_t last;			// Last request, answer or bytes received
+};
+
+// A request line waiting for a worker
+struct serve_request {
+    shared_ptr<serve_conn> conn;	// Connection to answer on
+    string line;			// The request without its newline
+};
+
+static deque<struct serve_request> pending;	// Requests waiting for a worker
+static unsigned int pending_limit;	// Most requests queued
+static mutex pending_lock;		// Guards pending and the connection flags
+static condition_variable pending_ready;	// A request was queued
+static int wake_pipe[2] = {-1, -1};	// Workers wake the polling thread
+
+static long long serve_max_instructions;	// Daemon instruction limit, 0 for none
+static double serve_max_seconds;		// Daemon time limit, 0 for none
+
+static thread_local struct results_file worker_results = {-1, -1};	// Results file of this worker
+static thread_local string worker_results_name;	// Its name, empty when none is open
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Configuration object
+// Outputs: Non-zero if apply_config can read every latency in it
+// /////////////////////////////////////////////////////////////////
+static int serve_config_check(const Json::Value & root) {
+    static const char * names[8] = {"add", "sub", "and", "nor", "div", "mul", "mod", "exp"};
+    int i;
+
+    if (!root.isObject()) {
+	return 0;
+    }
+    for (i = 0; i < 8; i++) {
+	if (root.isMember(names[i]) && !root[names[i]].isInt()) {
+	    return 0;
+	}
+    }
+
+    return 1;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Cache, file name and whether it holds a program
+// Outputs: The parsed file, or 0 if it does not exist or does not
+//          parse (or, for a configuration, holds a non-integer
+//          latency)
+// Description: Parses the file again when it changed since it was
+//              cached. A full cache drops its least recently used
+//              entry.
+// /////////////////////////////////////////////////////////////////
+static shared_ptr<const serve_file> serve_lookup(serve_cache & cache, const string & name, int is_program) {
+    struct stat st;			// File as it is now
+    shared_ptr<serve_file> entry;	// Newly parsed file
+    serve_cache::iterator it;		// Cached entry
+    serve_cache::iterator oldest;	// Entry to drop
+    ifstream in;			// Program or configuration file
+    Json::Value root;			// Parsed configuration
+    Json::CharReaderBuilder builder;	// Configuration parser
+    string errors;			// Why it did not parse
+
+    if (stat(name.c_str(), &st) != 0) {
+	return shared_ptr<const serve_file>();
+    }
+
+    {
+	lock_guard<mutex> hold(cache_lock);
+	it = cache.find(name);
+	if ((it != cache.end()) && (it->second->mtime == st.st_mtim.tv_sec) &&
+	    (it->second->mtime_nsec == st.st_mtim.tv_nsec) && (it->second->size == st.st_size)) {
+	    const_cast<serve_file *>(it->second.get())->used = ++cache_clock;
+	    return it->second;
+	}
+    }
+
+    // Parse with this thread's simulator state, outside the lock
+    entry = make_shared<serve_file>();
+    entry->mtime = st.st_mtim.tv_sec;
+    entry->mtime_nsec = st.st_mtim.tv_nsec;
+    entry->size = st.st_size;
+    in.open(name.c_str());
+    if (!in.is_open()) {
+	return shared_ptr<const serve_file>();
+    }
+    if (is_program) {
+	load_program(in);
+	entry->program.assign(inst_memory, inst_memory + program_size);
+    }
+    else {
+	// A bad configuration must not take the daemon down the way
+	// read_config's exception takes down a single run
+	if (!Json::parseFromStream(builder, in, &root, &errors) || !serve_config_check(root)) {
+	    return shared_ptr<const serve_file>();
+	}
+	apply_config(root);
+	memcpy(entry->latency, latency_vals, sizeof(entry->latency));
+    }
+
+    lock_guard<mutex> hold(cache_lock);
+    entry->used = ++cache_clock;
+    if ((cache.size() >= SERVE_CACHE_ENTRIES) && (cache.find(name) == cache.end())) {
+	oldest = cache.begin();
+	for (it = cache.begin(); it != cache.end(); it++) {
+	    if (it->second->used < oldest->second->used) {
+		oldest = it;
+	    }
+	}
+	cache.erase(oldest);
+    }
+    cache[name] = entry;
+
+    return entry;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Request options
+// Outputs: 0 if they are valid, with the thread's settings made, or
+//          the reason they are not
+// /////////////////////////////////////////////////////////////////
+static const char * serve_options(const Json::Value & options) {
+    string engine;			// Engine asked for
+
+    fast_enabled = 0;
+    memo_enabled = 0;
+    memo_kb = MEMO_DEFAULT_KB;
+    max_instructions = serve_max_instructions;
+    max_seconds = serve_max_seconds;
+    mem_size = MEM_SIZE;
+    mem_banks = 1;
+    perf_isa_enabled = 0;
+
+    if (!options.isObject()) {
+	return options.isNull() ? 0 : "options must be an object";
+    }
+
+    // Every value is checked before it is converted, since a conversion
+    // that fails throws
+    if (options.isMember("engine") && !options["engine"].isString()) {
+	return "engine must be fast or reference";
+    }
+    engine = options.get("engine", "reference").asString();
+    if (engine == "fast") {
+	fast_enabled = 1;
+    }
+    else if (engine != "reference") {
+	return "engine must be fast or reference";
+    }
+    if (options.isMember("memoize")) {
+	fast_enabled = 1;
+	memo_enabled = 1;
+	if (!options["memoize"].isIntegral()) {
+	    return "memoize must be a positive size in KB";
+	}
+	memo_kb = options["memoize"].asInt64();
+	if (memo_kb <= 0) {
+	    return "memoize must be a positive size in KB";
+	}
+    }
+    // Requests may lower the daemon's limits, not raise them
+    if (options.isMember("max_instructions")) {
+	if (!options["max_instructions"].isIntegral() || (options["max_instructions"].asInt64() <= 0)) {
+	    return "max_instructions must be positive";
+	}
+	if ((serve_max_instructions == 0) || (options["max_instructions"].asInt64() < serve_max_instructions)) {
+	    max_instructions = options["max_instructions"].asInt64();
+	}
+    }
+    if (options.isMember("max_seconds")) {
+	if (!options["max_seconds"].isNumeric() || (options["max_seconds"].asDouble() <= 0)) {
+	    return "max_seconds must be positive";
+	}
+	if ((serve_max_seconds == 0) || (options["max_seconds"].asDouble() < serve_max_seconds)) {
+	    max_seconds = options["max_seconds"].asDouble();
+	}
+    }
+    if (options.isMember("mem_size")) {
+	if (!options["mem_size"].isUInt()) {
+	    return "mem_size must be even and at most 65536";
+	}
+	mem_size = options["mem_size"].asUInt();
+	if ((mem_size < 2) || (mem_size > MEM_SIZE) || (mem_size & 0x0001)) {
+	    return "mem_size must be even and at most 65536";
+	}
+    }
+    if (options.isMember("perf_isa")) {
+	if (!options["perf_isa"].isBool()) {
+	    return "perf_isa must be true or false";
+	}
+	perf_isa_enabled = options["perf_isa"].asBool();
+    }
+    if (options.isMember("results") && (!options["results"].isString() || options["results"].asString().empty())) {
+	return "results must be a file name";
+    }
+    if (options.isMember("data_in") && !options["data_in"].isString()) {
+	return "data_in must be a file name";
+    }
+    if (options.isMember("mem_banks")) {
+	if (!options["mem_banks"].isUInt()) {
+	    return "mem_banks must be 1 to 8";
+	}
+	mem_banks = options["mem_banks"].asUInt();
+	if ((mem_banks < 1) || (mem_banks > MEM_MAX_BANKS)) {
+	    return "mem_banks must be 1 to 8";
+	}
+    }
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: One request
+// Outputs: Its response
+// Description: Runs the program the way main() does with --no-trace
+//              and the same options, on this thread's state
+// /////////////////////////////////////////////////////////////////
+static void serve_run(const Json::Value & request, Json::Value & response) {
+    shared_ptr<const serve_file> program;	// Program to run
+    shared_ptr<const serve_file> config;	// Its configuration
+    ostringstream output;			// Guest output of the run
+    istringstream text;				// Program sent in the request
+    Json::Value result;				// Output file of the run
+    const char * error;				// Why the request failed
+    null_tool no_tool;				// Uninstrumented engine
+    short int halt_all;				// Halting Flag
+    int size;					// Bytes of the program
+
+    if (!request.isObject()) {
+	response["error"] = "request must be an object";
+	return;
+    }
+
+    error = serve_options(request["options"]);
+    if (error) {
+	response["error"] = error;
+	return;
+    }
+
+    // Latencies
+    if (request["config"].isObject()) {
+	if (!serve_config_check(request["config"])) {
+	    response["error"] = "config latencies must be integers";
+	    return;
+	}
+	apply_config(request["config"]);
+    }
+    else if (request["config"].isString()) {
+	config = serve_lookup(cached_configs, request["config"].asString(), 0);
+	if (!config) {
+	    response["error"] = "config file does not exist or is not a valid configuration";
+	    return;
+	}
+	memcpy(latency_vals, config->latency, sizeof(latency_vals));
+    }
+    else {
+	response["error"] = "config must be a file name or an object";
+	return;
+    }
+
+    // Instruction memory
+    if (request["program_text"].isString()) {
+	text.str(request["program_text"].asString());
+	load_program(text);
+    }
+    else if (request["program"].isString()) {
+	program = serve_lookup(cached_programs, request["program"].asString(), 1);
+	if (!program) {
+	    response["error"] = "program file does not exist";
+	    return;
+	}
+	size = program->program.size();
+	if (program_size > size) {
+	    memset(&inst_memory[size], 0, program_size - size);
+	}
+	memcpy(inst_memory, program->program.data(), size);
+	program_size = size;
+    }
+    else {
+	response["error"] = "program or program_text is required";
+	return;
+    }
+
+    reset_state();
+    if (request["options"].isMember("data_in") &&
+	(mem_map_image(request["options"]["data_in"].asString().c_str()) != 0)) {
+	response["error"] = "data image could not be mapped";
+	return;
+    }
+    if (fast_enabled) {
+	block_reset();
+    }
+    if (memo_enabled && (memo_open() != 0)) {
+	memo_enabled = 0;
+    }
+
+    guest_out = &output;
+    periodic_start();
+    halt_all = fast_enabled ? run_fast() : run_engine(no_tool);
+    (void)halt_all;
+
+    if (limit_hit == LIMIT_INSTRUCTIONS) {
+	dump_state("Instruction limit reached...terminating");
+    }
+    else if (limit_hit == LIMIT_SECONDS) {
+	dump_state("Time limit reached...terminating");
+    }
+    guest_out = &cout;
+
+    build_output(result);
+    if (memo_enabled) {
+	memo_close();
+    }
+
+    response["exit"] = (limit_hit == LIMIT_INSTRUCTIONS) ? EXIT_INSTRUCTION_LIMIT :
+		       ((limit_hit == LIMIT_SECONDS) ? EXIT_TIME_LIMIT : 0);
+
+    // The worker keeps the last results file open for the next request
+    if (request["options"].isMember("results")) {
+	if (worker_results_name != request["options"]["results"].asString()) {
+	    results_close(&worker_results);
+	    worker_results_name = request["options"]["results"].asString();
+	    if (results_open(&worker_results, worker_results_name.c_str()) != 0) {
+		worker_results_name.clear();
+	    }
+	}
+	if (worker_results_name.empty() ||
+	    (results_append(&worker_results, program ? request["program"].asCString() : "-",
+			    config ? request["config"].asCString() : "-", response["exit"].asInt()) != 0)) {
+	    response = Json::Value();
+	    response["error"] = "results file could not be appended to";
+	    return;
+	}
+    }
+    response["output"] = output.str();
+    response["result"] = result;
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Connected socket and the text to send
+// Outputs: 0 once all of it was sent, -1 if the client went away
+// /////////////////////////////////////////////////////////////////
+static int serve_send(int fd, const string & text) {
+    size_t sent;			// Bytes sent so far
+    ssize_t n;
+
+    for (sent = 0; sent < text.size(); sent += n) {
+	n = send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+	if (n < 0) {
+	    if (errno == EINTR) {
+		n = 0;
+		continue;
+	    }
+	    return -1;
+	}
+    }
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Makes the polling thread look at the connections again
+// /////////////////////////////////////////////////////////////////
+static void serve_wake() {
+    char byte = 0;
+
+    // A full pipe already holds a wake up
+    if (write(wake_pipe[1], &byte, 1) < 0) {
+	return;
+    }
+
+    return;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Description: Answers queued request lines, one at a time
+// /////////////////////////////////////////////////////////////////
+static void serve_worker() {
+    Json::CharReaderBuilder reader_builder;	// Request parser
+    Json::StreamWriterBuilder writer_builder;	// Response writer
+    unique_ptr<Json::CharReader> reader(reader_builder.newCharReader());
+    struct serve_request job;			// Request being answered
+    Json::Value request;			// Its parsed line
+    Json::Value response;			// Its response
+    string errors;				// Why a request did not parse
+    int failed;					// The answer could not be sent
+    int was_full;				// The queue was full
+
+    // Requests never print a trace
+    trace_enabled = 0;
+    writer_builder["indentation"] = "";
+
+    while (1) {
+	{
+	    unique_lock<mutex> hold(pending_lock);
+	    pending_ready.wait(hold, [] { return !pending.empty(); });
+	    was_full = (pending.size() >= pending_limit);
+	    job = pending.front();
+	    pending.pop_front();
+	}
+	// Reading stopped while the queue was full
+	if (was_full) {
+	    serve_wake();
+	}
+
+	request = Json::Value();
+	response = Json::Value(Json::objectValue);
+	if (reader->parse(job.line.data(), job.line.data() + job.line.size(), &request, &errors)) {
+	    // No request may take the daemon down
+	    try {
+		serve_run(request, response);
+	    }
+	    catch (const Json::Exception & e) {
+		guest_out = &cout;
+		response = Json::Value(Json::objectValue);
+		response["error"] = string("request could not be run: ") + e.what();
+	    }
+	}
+	else {
+	    response["error"] = "request is not valid JSON";
+	}
+	failed = serve_send(job.conn->fd, Json::writeString(writer_builder, response) + "\n");
+
+	{
+	    lock_guard<mutex> hold(pending_lock);
+	    job.conn->busy = 0;
+	    job.conn->closing = failed;
+	    job.conn->last = time(0);
+	}
+	job.conn.reset();
+	serve_wake();
+    }
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Connections, the time now
+// Outputs: Non-zero when the queue is full
+// Description: Queues the next request line of every connection that
+//              has none queued or running, and closes connections that
+//              are done: the client closed and every line was
+//              answered, an answer could not be sent, the connection
+//              was idle for SERVE_IDLE_SECONDS or sent a line longer
+//              than SERVE_MAX_REQUEST
+// /////////////////////////////////////////////////////////////////
+static int serve_dispatch(map<int, shared_ptr<serve_conn> > & conns, time_t now) {
+    map<int, shared_ptr<serve_conn> >::iterator it;
+    struct serve_conn * conn;
+    struct serve_request job;
+    size_t end;					// End of the first line in buffer
+    int done;					// Close the connection
+
+    lock_guard<mutex> hold(pending_lock);
+
+    for (it = conns.begin(); it != conns.end(); ) {
+	conn = it->second.get();
+	if (conn->busy) {
+	    it++;
+	    continue;
+	}
+
+	end = conn->buffer.find('\n');
+	if ((end != string::npos) && !conn->closing) {
+	    if (pending.size() < pending_limit) {
+		job.conn = it->second;
+		job.line.assign(conn->buffer, 0, end);
+		conn->buffer.erase(0, end + 1);
+		conn->busy = 1;
+		conn->last = now;
+		pending.push_back(job);
+		pending_ready.notify_one();
+	    }
+	    it++;
+	    continue;
+	}
+
+	done = conn->closing || conn->eof || (conn->buffer.size() > SERVE_MAX_REQUEST) ||
+	       (now - conn->last >= SERVE_IDLE_SECONDS);
+	if (done) {
+	    close(conn->fd);
+	    it = conns.erase(it);
+	}
+	else {
+	    it++;
+	}
+    }
+
+    return pending.size() >= pending_limit;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Socket path, worker threads (0 for one per core), requests
+//         queued before reading stops, and the instruction and time
+//         limits of every run (0 for none)
+// Outputs: -1 if the socket could not be set up, otherwise never
+//          returns
+// /////////////////////////////////////////////////////////////////
+int serve(const char * path, int workers, int queue, long long limit_instructions, double limit_seconds) {
+    map<int, shared_ptr<serve_conn> > conns;	// Open connections by socket
+    vector<struct pollfd> fds;			// Sockets polled this round
+    shared_ptr<serve_conn> conn;		// Accepted connection
+    struct sockaddr_un addr;		// Socket address
+    struct stat st;			// Stale socket file
+    struct timeval idle;		// Send timeout
+    char chunk[65536];			// Bytes from one recv
+    time_t now;
+    ssize_t n;
+    int listen_fd;			// Listening socket
+    int full;				// The request queue is full
+    int fd;				// Accepted connection
+    int i;				// Count variable
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+	cout << "Socket path too long...terminating" << endl;
+	return -1;
+    }
+    if (workers <= 0) {
+	workers = thread::hardware_concurrency() ? thread::hardware_concurrency() : 1;
+    }
+    pending_limit = queue;
+    serve_max_instructions = limit_instructions;
+    serve_max_seconds = limit_seconds;
+
+    // A socket left behind by a previous daemon is replaced
+    if ((stat(path, &st) == 0) && S_ISSOCK(st.st_mode)) {
+	unlink(path);
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+	cout << "Unable to create socket...terminating" << endl;
+	return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    if ((bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) || (listen(listen_fd, queue) != 0) ||
+	(pipe2(wake_pipe, O_NONBLOCK | O_CLOEXEC) != 0)) {
+	cout << "Unable to listen on " << path << "...terminating" << endl;
+	close(listen_fd);
+	return -1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    for (i = 0; i < workers; i++) {
+	thread(serve_worker).detach();
+    }
+    cout << "Serving " << path << " with " << workers << " workers" << endl;
+
+    idle.tv_sec = SERVE_IDLE_SECONDS;
+    idle.tv_usec = 0;
+
+    while (1) {
+	now = time(0);
+	full = serve_dispatch(conns, now);
+
+	// Backpressure: nothing is read or accepted while the queue is
+	// full, connections with a request queued or running wait too
+	fds.clear();
+	fds.push_back({wake_pipe[0], POLLIN, 0});
+	if (!full) {
+	    if (conns.size() < SERVE_MAX_CONNECTIONS) {
+		fds.push_back({listen_fd, POLLIN, 0});
+	    }
+	    {
+		lock_guard<mutex> hold(pending_lock);
+		for (auto & entry : conns) {
+		    if (!entry.second->busy && !entry.second->eof && !entry.second->closing &&
+			(entry.second->buffer.find('\n') == string::npos)) {
+			fds.push_back({entry.first, POLLIN, 0});
+		    }
+		}
+	    }
+	}
+
+	// Wake at least every second to close idle connections
+	if (poll(fds.data(), fds.size(), 1000) <= 0) {
+	    continue;
+	}
+
+	now = time(0);
+	for (i = 0; i < (int)fds.size(); i++) {
+	    if (!fds[i].revents) {
+		continue;
+	    }
+	    if (fds[i].fd == wake_pipe[0]) {
+		while (read(wake_pipe[0], chunk, sizeof(chunk)) > 0) {
+		}
+	    }
+	    else if (fds[i].fd == listen_fd) {
+		fd = accept4(listen_fd, 0, 0, SOCK_CLOEXEC);
+		if (fd < 0) {
+		    continue;
+		}
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &idle, sizeof(idle));
+		conn = make_shared<serve_conn>();
+		conn->fd = fd;
+		conn->eof = 0;
+		conn->busy = 0;
+		conn->closing = 0;
+		conn->last = now;
+		conns[fd] = conn;
+	    }
+	    else {
+		conn = conns[fds[i].fd];
+		n = recv(conn->fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+		if (n > 0) {
+		    conn->buffer.append(chunk, n);
+		    conn->last = now;
+		}
+		else if ((n == 0) || ((errno != EINTR) && (errno != EAGAIN))) {
+		    conn->eof = 1;
+		}
+	    }
+	}
+	conn.reset();
+    }
+}
@@ -5,6 +5,21 @@
 // ////////////////////////////////////////////////////////
 
 #include "xlibrary.h"
+#include "xengine.h"
+#include "xsample.h"
+#include "xlive.h"
+#include "xinterval.h"
+#include "xwatch.h"
+#include "xfast.h"
+#include "xblock.h"
+#include "xmemo.h"
+#include "xanalyze.h"
+#include "xmem.h"
+#include "xserve.h"
+#include "xcore.h"
+#include "xresults.h"
+#include "xperf.h"
+#include <dlfcn.h>
 
 using namespace std;
 
@@ -13,22 +28,8 @@ using namespace std;
 // ////////////////////////////////////////////////////////
 // Function Prototypes
 // ////////////////////////////////////////////////////////
-void hex2bin (string line, unsigned char * instruction);
-void read_data_mem();
-void write_data_mem();
-void read_config(char * filename);
-void write_output(char * filename);
-// ///////////////////////////////////////////////////////
-
-// ///////////////////////////////////////////////////////
-// Global Variables
-// ///////////////////////////////////////////////////////
-int latency_vals[8];			// Latency values of arithmetic instructions
-int clock_cycles[22];			// Number of cycles per instruction
-unsigned char inst_memory[MEM_SIZE];	// Instruction Memory
-unsigned char data_memory[MEM_SIZE];	// Data Memory
-short int reg_file[8];			// Register File
-unsigned short int program_counter;	// Program Counter
+void print_usage(char * program);
+struct xsim_plugin * load_plugin(const char * spec);
 // ///////////////////////////////////////////////////////
 
 int main (int argc, char *argv[]) {
@@ -36,27 +37,258 @@ int main (int argc, char *argv[]) {
     char inputfile[FILE_STRING_SIZE];		// Char String for input file
     char configfile[FILE_STRING_SIZE];		// Char string for configuration file
     char outputstatfile[FILE_STRING_SIZE];	// Char string for output file
+    char profilefile[FILE_STRING_SIZE];		// Char string for profile base name
+    char intervalfile[FILE_STRING_SIZE + 8];	// Char string for interval stats
+    const char * pluginspec;			// Plugin file and arguments
+    const char * datain;			// Initial data memory image
+    const char * dataout;			// Final data memory image
+    const char * datadiff;			// Words changed by the run
+    const char * servepath;			// Socket to serve runs on
+    const char * resultspath;			// Columnar results file
+    struct results_file results;		// It, while appending
+    int exit_code;				// Exit code of the run
+    int serveworkers;				// Worker threads of the daemon
+    int servequeue;				// Requests queued for workers
 
     int i;					// Count variable
 
     short int halt_all;				// Halting Flag
 
     ifstream infile;				// Input File
-    string line;				// String for instruction line
 
-    short int instruction;			// 16-Bit value of instruction
-    unsigned short int opcode;			// Opcode Value
+    null_tool no_tool;				// Uninstrumented engine
+    plugin_tool plugin;				// Engine calling a loaded plugin
+    sample_tool sampler;			// Engine publishing what --sample reads
+    analysis_tool analyses;			// Engine with the trace and analyses
+
+    int option;					// Command line option
+    char * suffix;				// Text after a number
+
+    // Long options accepted before the file names
+    static struct option long_options[] = {
+	{"critical-path", no_argument, 0, 'c'},
+	{"profile", optional_argument, 0, 'p'},
+	{"sample", optional_argument, 0, 's'},
+	{"self-profile", no_argument, 0, 'P'},
+	{"no-trace", no_argument, 0, 'q'},
+	{"live", no_argument, 0, 'l'},
+	{"stats-interval", required_argument, 0, 'i'},
+	{"plugin", required_argument, 0, 'x'},
+	{"watch", required_argument, 0, 'w'},
+	{"max-instructions", required_argument, 0, 'I'},
+	{"max-seconds", required_argument, 0, 'T'},
+	{"engine", required_argument, 0, 'e'},
+	{"memoize", optional_argument, 0, 'm'},
+	{"analyze", no_argument, 0, 'a'},
+	{"mem-size", required_argument, 0, 'M'},
+	{"mem-banks", required_argument, 0, 'B'},
+	{"mem-stats", no_argument, 0, 'S'},
+	{"data-in", required_argument, 0, 'D'},
+	{"data-out", required_argument, 0, 'O'},
+	{"data-diff", required_argument, 0, 'F'},
+	{"serve", required_argument, 0, 'U'},
+	{"workers", required_argument, 0, 'W'},
+	{"queue", required_argument, 0, 'Q'},
+	{"results", required_argument, 0, 'R'},
+	{"perf-isa", no_argument, 0, 'X'},
+	{0, 0, 0, 0}
+    };
+
+    profilefile[0] = '\0';
+    pluginspec = 0;
+    plugin.plugin = 0;
+    datain = 0;
+    dataout = 0;
+    datadiff = 0;
+    servepath = 0;
+    resultspath = 0;
+    serveworkers = 0;
+    servequeue = SERVE_DEFAULT_QUEUE;
+
+    // Parse options
+    while ((option = getopt_long(argc, argv, "", long_options, 0)) != -1) {
+	switch (option) {
+	    case 'c':
+		critpath_enabled = 1;
+		break;
+	    case 'p':
+		profile_enabled = 1;
+		if (optarg) {
+		    strncpy(profilefile, optarg, FILE_STRING_SIZE - 1);
+		    profilefile[FILE_STRING_SIZE - 1] = '\0';
+		}
+		break;
+	    case 's':
+		sample_enabled = 1;
+		if (optarg) {
+		    sample_interval_usec = atol(optarg);
+		    if (sample_interval_usec <= 0) {
+			print_usage(argv[0]);
+			return -1;
+		    }
+		}
+		break;
+	    case 'P':
+		selfprof_enabled = 1;
+		break;
+	    case 'q':
+		trace_enabled = 0;
+		break;
+	    case 'l':
+		live_enabled = 1;
+		break;
+	    case 'x':
+		pluginspec = optarg;
+		break;
+	    case 'I':
+		max_instructions = atoll(optarg);
+		if (max_instructions <= 0) {
+		    print_usage(argv[0]);
+		    return -1;
+		}
+		break;
+	    case 'T':
+		max_seconds = atof(optarg);
+		if (max_seconds <= 0) {
+		    print_usage(argv[0]);
+		    return -1;
+		}
+		break;
+	    case 'w':
+		if (watch_add(optarg) != 0) {
+		    cout << "Invalid watchpoint: " << optarg << endl;
+		    print_usage(argv[0]);
+		    return -1;
+		}
+		break;
+	    case 'e':
+		if (strcmp(optarg, "fast") == 0) {
+		    fast_enabled = 1;
+		}
+		else if (strcmp(optarg, "reference") == 0) {
+		    fast_enabled = 0;
+		}
+		else {
+		    print_usage(argv[0]);
+		    return -1;
+		}
+		break;
+	    case 'a':
+		analyze_enabled = 1;
+		break;
+	    case 'm':
+		fast_enabled = 1;
+		memo_enabled = 1;
+		if (optarg) {
+		    memo_kb = atol(optarg);
+		    if (memo_kb <= 0) {
+			print_usage(argv[0]);
+			return -1;
+		    }
+		}
+		break;
+	    case 'M':
+		mem_size = strtol(optarg, &suffix, 10);
+		if ((*suffix == 'k') || (*suffix == 'K')) {
+		    mem_size *= 1024;
+		    suffix++;
+		}
+		if (*suffix || (mem_size < 2) || (mem_size > MEM_SIZE) || (mem_size & 0x0001)) {
+		    print_usage(argv[0]);
+		    return -1;
+		}
+		break;
+	    case 'B':
+		mem_banks = atoi(optarg);
+		if ((mem_banks < 1) || (mem_banks > MEM_MAX_BANKS)) {
+		    print_usage(argv[0]);
+		    return -1;
+		}
+		break;
+	    case 'S':
+		mem_stats_enabled = 1;
+		break;
+	    case 'D':
+		datain = optarg;
+		break;
+	    case 'O':
+		dataout = optarg;
+		break;
+	    case 'F':
+		datadiff = optarg;
+		break;
+	    case 'U':
+		servepath = optarg;
+		break;
+	    case 'R':
+		resultspath = optarg;
+		break;
+	    case 'X':
+		perf_isa_enabled = 1;
+		break;
+	    case 'W':
+		serveworkers = atoi(optarg);
+		if (serveworkers <= 0) {
+		    print_usage(argv[0]);
+		    return -1;
+		}
+		break;
+	    case 'Q':
+		servequeue = atoi(optarg);
+		if (servequeue <= 0) {
+		    print_usage(argv[0]);
+		    return -1;
+		}
+		break;
+	    case 'i':
+		interval_length = atoll(optarg);
+		if (interval_length <= 0) {
+		    print_usage(argv[0]);
+		    return -1;
+		}
+		break;
+	    default:
+		print_usage(argv[0]);
+		return -1;
+	}
+    }
+
+    // Each request names its own files; the limits bound every run
+    if (servepath) {
+	return serve(servepath, serveworkers, servequeue, max_instructions, (max_seconds > 0) ? max_seconds : SERVE_DEFAULT_SECONDS);
+    }
 
     // Check for valid execution parameters
-    if (argc != 4) {
-	cout << "Invalid Usage...\n\t" << argv[0] << " input_file configuration_file output_file" << endl;
+    if ((argc - optind) != 3) {
+	print_usage(argv[0]);
 	return -1;
     }
 
     // copy parameters to strings
-    strcpy(inputfile, argv[1]);
-    strcpy(configfile, argv[2]);
-    strcpy(outputstatfile, argv[3]);
+    strcpy(inputfile, argv[optind]);
+    strcpy(configfile, argv[optind + 1]);
+    strcpy(outputstatfile, argv[optind + 2]);
+
+    // The fast engine has no per-instruction hooks
+    if (fast_enabled) {
+	trace_enabled = 0;
+	if (critpath_enabled || profile_enabled || pluginspec || watch_count || sample_enabled) {
+	    cout << "Fast engine does not support instrumentation...using reference engine" << endl;
+	    fast_enabled = 0;
+	    memo_enabled = 0;
+	}
+    }
+
+    // Phases and guest MIPS are timed on any engine, handlers only on
+    // the reference engine
+    if (fast_enabled) {
+	selfprof_buckets = 0;
+    }
+
+    // Profile reports are named after the output file by default
+    if (profile_enabled && (profilefile[0] == '\0')) {
+	strcpy(profilefile, outputstatfile);
+    }
 
 #ifdef DEBUG
 
@@ -66,6 +298,11 @@ int main (int argc, char *argv[]) {
 
 #endif
 
+    // Open the cycle counter before anything is timed
+    if (selfprof_enabled) {
+	selfprof_init();
+    }
+
     // Open the input file
     infile.open(inputfile);
     // Make sure file is open and exists
@@ -75,431 +312,301 @@ int main (int argc, char *argv[]) {
     }
 
     // Read configuration file
+    if (selfprof_enabled) {
+	selfprof_phase_begin(SP_CONFIG);
+    }
     read_config(configfile);
+    if (selfprof_enabled) {
+	selfprof_phase_end(SP_CONFIG);
+	selfprof_phase_begin(SP_LOAD);
+    }
+
+    // set data, registers and clock cycles to 0
+    reset_state();
 
-    // set data and clock cycles to 0
-    memset(data_memory, 0, sizeof(data_memory));
-    memset(clock_cycles, 0, sizeof(clock_cycles));
+    // Data memory starts out as the image, shared until stored to
+    if (datain && (mem_map_image(datain) != 0)) {
+	cout << "Data Image Could Not Be Mapped...Terminating" << endl;
+	return -1;
+    }
+
+    // Clear dataflow ready times
+    if (critpath_enabled) {
+	critpath_reset();
+    }
+
+    // Clear profile counters
+    if (profile_enabled) {
+	profile_reset();
+    }
 
     // Set halt flag to 0
     halt_all = (short int) 0;
-    // Set program counter to address 0
-    program_counter = 0;
-
-    // Set count variable to 0
-    i = 0;
 
     // Read the input file
-    while(getline(infile, line)) {
-	// Ignore Comments
-	if (line[0] != '#') {
-	    // Convert hex to binary representation
-	    hex2bin(line.substr(0,2), &inst_memory[i++]);
-	    hex2bin(line.substr(2,2), &inst_memory[i]);
-	    i++;
-	}
-    }
+    i = load_program(infile);
 
     // Close the input file
     infile.close();
 
-#ifdef DEBUG
-
-    cout << "Num Instructions: "<< (i/2) << endl;
-
-#endif
-
-    // Loop until halt flag is set or error occurs
-    while ((!halt_all) && (program_counter != (unsigned short int)-1)) {
-
-#ifdef DEBUG
-	    cout << "PC: " << program_counter << endl;
-#endif
-
-	    // Get instruction from instruction memory
-	    instruction = (unsigned short int)(inst_memory[program_counter] << 8) | (unsigned short int)(inst_memory[program_counter + 1]);
-
-	    // Get the opcode of instruction
-	    get_opcode(instruction, &opcode);
-
-#if 1
-	    cout << hex << instruction << "\t" << dec;
-#endif
-
-#if 1
-	    // Perform appropriate operation based on opcode		
-	    switch (opcode){
-		case (0x00):
-		    program_counter = x_add(instruction);
-		    break;
-		case (0x01):
-		    program_counter = x_sub(instruction);
-		    break;
-		case (0x02):
-		    program_counter = x_and(instruction);
-		    break;
-		case (0x03):
-		    program_counter = x_nor(instruction);
-		    break;
-		case (0x04):
-		    program_counter = x_div(instruction);
-		    break;
-		case (0x05):
-		    program_counter = x_mul(instruction);
-		    break;
-		case (0x06):
-		    program_counter = x_mod(instruction);
-		    break;
-		case (0x07):
-		    program_counter = x_exp(instruction);
-		    break;
-		case (0x08):
-		    program_counter = x_lw(instruction);
-		    break;
-		case (0x09):
-		    program_counter = x_sw(instruction);
-		    break;
-		case (0x10):
-		    program_counter = x_liz(instruction);
-		    break;
-		case (0x11):
-		    program_counter = x_lis(instruction);
-		    break;
-		case (0x12):
-		    program_counter = x_lui(instruction);
-		    break;
-		case (0x14):
-		    program_counter = x_bp(instruction);
-		    break;
-		case (0x15):
-		    program_counter = x_bn(instruction);
-		    break;
-		case (0x16):
-		    program_counter = x_bx(instruction);
-		    break;
-		case (0x17):
-		    program_counter = x_bz(instruction);
-		    break;
-		case (0x0C):
-		    program_counter = x_jr(instruction);
-		    break;
-		case (0x13):
-		    program_counter = x_jalr(instruction);
-		    break;
-		case (0x18):
-		    program_counter = x_j(instruction);
-		    break;
-		case (0x0D):
-		    halt_all = x_halt(instruction);
-		    break;
-		case (0x0E):
-		    program_counter = x_put(instruction);
-		    break;
-		default:
-		    cout << "Invalid Opcode: " << opcode << endl;
-		    program_counter += 2;
-		    break;
-	    }
-#endif
+    // Blocks are decoded from the program just loaded
+    if (fast_enabled) {
+	block_reset();
+    }
 
-#ifdef DEBUG
-	    cout << endl;
-#endif
+    // Remember register-only blocks
+    if (memo_enabled && (memo_open() != 0)) {
+	cout << "Unable to allocate memo table" << endl;
+	memo_enabled = 0;
     }
 
-    // Write output stats after program terminates
-    write_output(outputstatfile);
+    // Loading includes reading the program and clearing state
+    if (selfprof_enabled) {
+	selfprof_phase_end(SP_LOAD);
+    }
 
 #ifdef DEBUG
 
-    write_data_mem();
+    cout << "Num Instructions: "<< (i/2) << endl;
 
 #endif
 
-    return 0;
-}
-
-// ////////////////////////////////////////////////////////////////
-// Local Procedures
-// ////////////////////////////////////////////////////////////////
+    // Report on the program without running it
+    if (analyze_enabled) {
+	analyze_write(outputstatfile);
+	return 0;
+    }
 
-void hex2bin (string line, unsigned char * instruction) {
-    int i;			// Counting variable
-    unsigned short int temp;	// temporary value
+    // Load the instrumentation plugin
+    if (pluginspec) {
+	plugin.plugin = load_plugin(pluginspec);
+	if (!plugin.plugin) {
+	    return -1;
+	}
+    }
 
-    // Initialize values
-    *instruction = 0;
-    temp = 0;
+    // Start the sampling timer
+    if (sample_enabled && (sample_start() != 0)) {
+	cout << "Unable to start sampling timer" << endl;
+	sample_enabled = 0;
+    }
 
-    i = 0;
+    // Publish live metrics for xsim-top
+    if (live_enabled && (live_open(inputfile) != 0)) {
+	cout << "Unable to create live metrics segment" << endl;
+	live_enabled = 0;
+    }
 
-    // Loop while line is a character or digit
-    while (isalnum(line[i])) {
-	// Shift temp
-	temp = temp << 4;
-	
-	// Convert hex to number
-	if ((line[i] >= 'A') && (line[i] <= 'F')) {
-	    temp=(temp|((line[i]-'A'+10)));
-	}
-	else if ((line[i] >= 'a') && (line[i] <= 'f')) {
-	    temp=(temp|((line[i]-'a'+10)));
-	}
-	else {
-	    temp=(temp|((line[i]-'0')));
+    // Stream interval stats next to the output file
+    if (interval_length > 0) {
+	snprintf(intervalfile, sizeof(intervalfile), "%s.jsonl", outputstatfile);
+	if (interval_open(intervalfile) != 0) {
+	    cout << "Unable to open interval stats file " << intervalfile << endl;
+	    interval_length = 0;
 	}
-
-	i++;
     }
 
-    // Copy temp
-    memcpy(instruction, &temp, sizeof(char));
+    // Periodic work is only scheduled when something needs it
+    periodic_start();
 
-    return;
-}
+    // Time the execution loop
+    if (selfprof_enabled) {
+	selfprof_phase_begin(SP_EXEC);
+    }
 
-// /////////////////////////////////////////////////////////////////
-// This function is for debugging purposes
-// /////////////////////////////////////////////////////////////////
-void read_data_mem() {
-    ifstream mem_file;
-    string line1, line2;
-    unsigned char temp1, temp2;
-    int i;
+    // Run the program, instrumented only as much as wanted
+    if (fast_enabled) {
+	halt_all = run_fast();
+    }
+    else if (plugin.plugin) {
+	halt_all = run_engine(plugin);
+    }
+    else if (sample_enabled) {
+	halt_all = run_engine(sampler);
+    }
+    else if (trace_enabled || critpath_enabled || profile_enabled || selfprof_enabled) {
+	halt_all = run_engine(analyses);
+    }
+    else {
+	halt_all = run_engine(no_tool);
+    }
 
-    mem_file.open("data_mem.txt");
+    if (selfprof_enabled) {
+	selfprof_phase_end(SP_EXEC);
+    }
 
-    if (!mem_file.is_open()) {
-	cout << "File Does Not Exist" << endl;
+    // Say why a limit stopped the program
+    if (limit_hit == LIMIT_INSTRUCTIONS) {
+	dump_state("Instruction limit reached...terminating");
+    }
+    else if (limit_hit == LIMIT_SECONDS) {
+	dump_state("Time limit reached...terminating");
     }
 
-    i = 0;
+    // Last partial interval
+    if (interval_length > 0) {
+	interval_close();
+    }
 
-    while (mem_file >> line1) {
-	mem_file >> line2;
-	temp1 = 0;
-	temp2 = 0;
+    // Publish the final counters
+    if (live_enabled) {
+	live_close(halt_all ? LIVE_HALTED : (limit_hit ? LIVE_LIMIT : LIVE_ERROR));
+    }
 
-	hex2bin(line1, &temp1);
-	hex2bin(line2, &temp2);
+    // Stop sampling before any reporting
+    if (sample_enabled) {
+	sample_stop();
+    }
 
-	data_memory[i++] = temp1;
-	data_memory[i++] = temp2;
+    // Write output stats after program terminates
+    if (selfprof_enabled) {
+	selfprof_phase_begin(SP_OUTPUT);
+    }
+    write_output(outputstatfile);
+    if (selfprof_enabled) {
+	selfprof_phase_end(SP_OUTPUT);
     }
 
-    mem_file.close();
+    // Runs cut short by a limit get their own exit code
+    exit_code = 0;
+    if (limit_hit == LIMIT_INSTRUCTIONS) {
+	exit_code = EXIT_INSTRUCTION_LIMIT;
+    }
+    else if (limit_hit == LIMIT_SECONDS) {
+	exit_code = EXIT_TIME_LIMIT;
+    }
 
-    return;
-}
+    // One row for the sweep this run belongs to
+    if (resultspath) {
+	if ((results_open(&results, resultspath) != 0) ||
+	    (results_append(&results, inputfile, configfile, exit_code) != 0)) {
+	    cout << "Unable to append to results file " << resultspath << endl;
+	}
+	results_close(&results);
+    }
 
-// Convert a binary value back to hex
-char bin2hex (short int onebyte) {
-    char hex_val;		// hex value
-
-    // Convert
-    switch (onebyte) {
-	case 0:
-	    hex_val = '0';
-	    break;
-	case 1:
-	    hex_val = '1';
-	    break;
-	case 2:
-	    hex_val = '2';
-	    break;
-	case 3:
-	    hex_val = '3';
-	    break;
-	case 4:
-	    hex_val = '4';
-	    break;
-	case 5:
-	    hex_val = '5';
-	    break;
-	case 6:
-	    hex_val = '6';
-	    break;
-	case 7:
-	    hex_val = '7';
-	    break;
-	case 8:
-	    hex_val = '8';
-	    break;
-	case 9:
-	    hex_val = '9';
-	    break;
-	case 10:
-	    hex_val = 'A';
-	    break;
-	case 11:
-	    hex_val = 'B';
-	    break;
-	case 12:
-	    hex_val = 'C';
-	    break;
-	case 13:
-	    hex_val = 'D';
-	    break;
-	case 14:
-	    hex_val = 'E';
-	    break;
-	case 15:
-	    hex_val = 'F';
-	    break;
-	default:
-	    break;
-    }
-
-    return hex_val;
-}
+    // Write final data memory
+    if (dataout && (mem_write_image(dataout) != 0)) {
+	cout << "Unable to write data image " << dataout << endl;
+    }
+    if (datadiff && (mem_write_diff(datadiff) != 0)) {
+	cout << "Unable to write data diff " << datadiff << endl;
+    }
 
-// ///////////////////////////////////////////////////////////////////////
-// This function is for debugging purposes
-// ///////////////////////////////////////////////////////////////////////
-void write_data_mem() {
-    ofstream outfile;
-    int i;
-    int j;
-    short int temp;
-    char line[2];
-
-    outfile.open("data_mem.txt", ios::trunc);
-
-    j = 0;
-
-    if (outfile.is_open()) {
-	for (i = 0; i < (MEM_SIZE/2); i++) {
-	    temp = data_memory[i];
-	    outfile << bin2hex(((temp >> 4) & 0x000F)) << bin2hex(((temp) & 0x000F)) << "\n";
-	    temp = data_memory[++i];
-	    outfile << bin2hex(((temp >> 4) & 0x000F)) << bin2hex(((temp) & 0x000F)) << "\n";
-	    outfile.flush();
-	}
+    // Write profile reports
+    if (profile_enabled) {
+	profile_write(profilefile);
     }
 
-    outfile.close();
-}
+    // Print guest hot spots
+    if (sample_enabled) {
+	sample_report();
+    }
 
-// Read the configuration file
-void read_config(char * filename) {
-    Json::Value root;		// JSON variable
-    ifstream test(filename);	// Input file
+    // Print where the simulator spent its time
+    if (selfprof_enabled) {
+	selfprof_report();
+    }
 
-    // Copy configuration to root
-    test >> root;
+    // Print how often memoized blocks were reused
+    if (memo_enabled) {
+	memo_report();
+	memo_close();
+    }
 
-    // Pull out values
-    latency_vals[ADD] = root.get("add", 1).asInt();
-    latency_vals[SUB] = root.get("sub", 1).asInt();
-    latency_vals[AND] = root.get("and", 1).asInt();
-    latency_vals[NOR] = root.get("nor", 1).asInt();
-    latency_vals[DIV] = root.get("div", 1).asInt();
-    latency_vals[MUL] = root.get("mul", 1).asInt();
-    latency_vals[MOD] = root.get("mod", 1).asInt();
-    latency_vals[EXP] = root.get("exp", 1).asInt();
+    // Print how much data memory was stored to
+    if (mem_stats_enabled) {
+	mem_report();
+    }
 
 #ifdef DEBUG
 
-    cout << "Add: " << latency_vals[ADD] << endl;
-    cout << "Sub: " << latency_vals[SUB] << endl;
-    cout << "And: " << latency_vals[AND] << endl;
-    cout << "NOR: " << latency_vals[NOR] << endl;
-    cout << "DIV: " << latency_vals[DIV] << endl;
-    cout << "MUL: " << latency_vals[MUL] << endl;
-    cout << "Mod: " << latency_vals[MOD] << endl;
-    cout << "EXP: " << latency_vals[EXP] << endl;
+    write_data_mem();
 
 #endif
 
-    return;
+    return exit_code;
 }
 
-// Write the output stats
-void write_output (char * filename) {
-    ofstream outfile;				// Output file
-    Json::Value stat_obj;			// JSON objects
-    Json::Value stat_array(Json::arrayValue);
-    Json::Value array;
-    Json::Value reg_obj;
-    Json::Value reg_array(Json::arrayValue);
-    Json::StyledWriter styledWriter;
-
-    // Initialize values
-    int inst_count = 0;
-    int num_cycles = 0;
-    int i;
-
-    // Copy values in the register
-    reg_obj["r0"] = reg_file[0];
-    reg_obj["r1"] = reg_file[1];
-    reg_obj["r2"] = reg_file[2];
-    reg_obj["r3"] = reg_file[3];
-    reg_obj["r4"] = reg_file[4];
-    reg_obj["r5"] = reg_file[5];
-    reg_obj["r6"] = reg_file[6];
-    reg_obj["r7"] = reg_file[7];
-
-    // Append as array
-    reg_array.append(reg_obj);
-
-    // Copy instruction stats
-    stat_obj["add"] = clock_cycles[N_ADD];
-    stat_obj["sub"] = clock_cycles[N_SUB];
-    stat_obj["and"] = clock_cycles[N_AND];
-    stat_obj["nor"] = clock_cycles[N_NOR];
-    stat_obj["div"] = clock_cycles[N_DIV];
-    stat_obj["mul"] = clock_cycles[N_MUL];
-    stat_obj["mod"] = clock_cycles[N_MOD];
-    stat_obj["exp"] = clock_cycles[N_EXP];
-    stat_obj["lw"] = clock_cycles[N_LW];
-    stat_obj["sw"] = clock_cycles[N_SW];
-    stat_obj["liz"] = clock_cycles[N_LIZ];
-    stat_obj["lis"] = clock_cycles[N_LIS];
-    stat_obj["lui"] = clock_cycles[N_LUI];
-    stat_obj["bp"] = clock_cycles[N_BP];
-    stat_obj["bn"] = clock_cycles[N_BN];
-    stat_obj["bx"] = clock_cycles[N_BX];
-    stat_obj["bz"] = clock_cycles[N_BZ];
-    stat_obj["jr"] = clock_cycles[N_JR];
-    stat_obj["jal"] = clock_cycles[N_JAL];
-    stat_obj["j"] = clock_cycles[N_J];
-    stat_obj["halt"] = clock_cycles[N_HALT];
-    stat_obj["put"] = clock_cycles[N_PUT];
-
-    // Calculate number of cycles and instruction count
-    for (i = 0; i < 22; i++) {
-	inst_count += clock_cycles[i];
-	if (i < 8) {
-	    num_cycles += (clock_cycles[i] * latency_vals[i]);
-	}
-	else {
-	    num_cycles += clock_cycles[i];
-	}
-    }
+// ////////////////////////////////////////////////////////////////
+// Local Procedures
+// ////////////////////////////////////////////////////////////////
 
-    // Copy counts
-    stat_obj["instructions"] = inst_count;
-    stat_obj["cycles"] = num_cycles;
+void print_usage(char * program) {
+    cout << "Invalid Usage...\n\t" << program << " [options] input_file configuration_file output_file" << endl;
+    cout << "Options:" << endl;
+    cout << "\t--critical-path\t\tReport dataflow critical path and ideal ILP" << endl;
+    cout << "\t--profile[=NAME]\tWrite NAME.profile.json and NAME.folded (NAME defaults to output_file)" << endl;
+    cout << "\t--sample[=USEC]\t\tSample the guest PC every USEC of CPU time (default " << SAMPLE_DEFAULT_USEC << ")" << endl;
+    cout << "\t--self-profile\t\tReport host time per phase and per instruction class, and guest MIPS" << endl;
+    cout << "\t--no-trace\t\tDo not print the instruction trace" << endl;
+    cout << "\t--live\t\t\tPublish live progress for xsim-top" << endl;
+    cout << "\t--stats-interval=N\tStream stats deltas every N instructions to output_file.jsonl" << endl;
+    cout << "\t--plugin=FILE[:ARGS]\tLoad an instrumentation plugin (see include/xplugin.h)" << endl;
+    cout << "\t--max-instructions=N\tStop after N instructions (exit code " << EXIT_INSTRUCTION_LIMIT << ")" << endl;
+    cout << "\t--max-seconds=S\t\tStop after S seconds of execution (exit code " << EXIT_TIME_LIMIT << ")" << endl;
+    cout << "\t--watch=KINDS:ADDR[-END][:stop|:dump]\n\t\t\t\tWatch data memory for r(ead), w(rite) or c(hange)" << endl;
+    cout << "\t--engine=fast\t\tRun predecoded blocks without the trace or instrumentation" << endl;
+    cout << "\t--analyze\t\tWrite a static analysis of the program to output_file instead of running it" << endl;
+    cout << "\t--memoize[=KB]\t\tFast engine reusing results of register-only blocks (default " << MEMO_DEFAULT_KB << " KB)" << endl;
+    cout << "\t--mem-size=BYTES[K]\tBytes of data memory in each bank (default " << MEM_SIZE << ")" << endl;
+    cout << "\t--mem-banks=N\t\tLet LW/SW select one of N banks of data memory (1-" << MEM_MAX_BANKS << ")" << endl;
+    cout << "\t--mem-stats\t\tReport the data memory pages stored to" << endl;
+    cout << "\t--data-in=FILE\t\tStart with data memory mapped from a binary image" << endl;
+    cout << "\t--data-out=FILE\t\tWrite final data memory as a binary image" << endl;
+    cout << "\t--data-diff=FILE\tList the data memory words the run changed" << endl;
+    cout << "\t--perf-isa\t\tEnable RDCYC, RDINST, RDEVT and MARK (see include/xperf.h)" << endl;
+    cout << "\t--results=FILE\t\tAppend the registers and stats as a row of a columnar results file" << endl;
+    cout << "\t--serve=SOCKET\t\tAnswer run requests on a Unix socket instead (no file arguments)" << endl;
+    cout << "\t--workers=N\t\tRuns served at once (default one per core)" << endl;
+    cout << "\t--queue=N\t\tRequests waiting for a worker before reading stops (default " << SERVE_DEFAULT_QUEUE << ")" << endl;
+    cout << "\t\t\t\tServed runs are limited by --max-instructions and --max-seconds (default " << SERVE_DEFAULT_SECONDS << " s)" << endl;
 
-    // Append as array
-    stat_array.append(stat_obj);
- 
-    // Combine as 1 object
-    array["registers"] = reg_array;  
-    array["stats"] = stat_array;  
+    return;
+}
 
-#ifdef DEBUG
+// /////////////////////////////////////////////////////////////////
+// Inputs: Plugin file name, optionally followed by ':' and arguments
+// Outputs: Initialized plugin, or 0 if it could not be loaded
+// /////////////////////////////////////////////////////////////////
+struct xsim_plugin * load_plugin(const char * spec) {
+    static struct xsim_plugin loaded;	// Callbacks of the plugin
+    string filename;			// Shared object to open
+    string args;			// Text passed to the plugin
+    void * handle;			// dlopen handle
+    xsim_plugin_init_fn init;		// Plugin entry point
+    size_t colon;
+
+    filename = spec;
+    colon = filename.find(':');
+    if (colon != string::npos) {
+	args = filename.substr(colon + 1);
+	filename = filename.substr(0, colon);
+    }
 
-    cout << endl << endl << array << endl;
+    // A bare name would be searched in the library path only
+    if (filename.find('/') == string::npos) {
+	filename = "./" + filename;
+    }
 
-#endif
+    handle = dlopen(filename.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+	cout << "Unable to load plugin: " << dlerror() << endl;
+	return 0;
+    }
 
-    // Open output
-    outfile.open(filename);
+    init = (xsim_plugin_init_fn)dlsym(handle, XSIM_PLUGIN_INIT);
+    if (!init) {
+	cout << "Plugin " << filename << " has no " << XSIM_PLUGIN_INIT << endl;
+	return 0;
+    }
 
-    // Write stats
-    outfile << styledWriter.write(array);
+    memset(&loaded, 0, sizeof(loaded));
+    loaded.version = XSIM_PLUGIN_VERSION;
+    if (init(&loaded, args.c_str()) != 0) {
+	cout << "Plugin " << filename << " failed to initialize" << endl;
+	return 0;
+    }
 
-    // Close
-    outfile.close();
+    return &loaded;
 }
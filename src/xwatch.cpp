@@ -0,0 +1,168 @@
+// //////////////////////////////////////////////////////////////////
+// File: xwatch.cpp
+// Description: Watchpoints on data memory words and ranges. The shadow
+//              bitmap makes the common case (an access nothing watches)
+//              a single bit test in x_lw/x_sw. Only accesses that hit
+//              the bitmap look at the watchpoint list.
+// Author: ZDHull
+// Date: 2026/10/19
+// //////////////////////////////////////////////////////////////////
+
+#include "xwatch.h"
+
+using namespace std;
+
+// Actions when a watchpoint triggers
+#define WATCH_REPORT 0
+#define WATCH_STOP 1
+#define WATCH_DUMP 2
+
+// //////////////////////////////////////////
+// Extern variables shared amoung files
+extern __thread short int reg_file[8];
+extern __thread unsigned short int program_counter;
+// //////////////////////////////////////////
+
+// One watched address range
+struct watchpoint {
+    unsigned short int first;	// First byte watched
+    unsigned short int last;	// Last byte watched
+    int kinds;			// WATCH_READ, WATCH_WRITE, WATCH_CHANGE
+    int action;			// WATCH_REPORT, WATCH_STOP, WATCH_DUMP
+    unsigned long long hits;	// Times triggered
+};
+
+unsigned long long watch_bitmap[MEM_SIZE/64];	// Shadow bitmap
+struct watchpoint watch_list[MAX_WATCH];	// Watchpoints set
+int watch_count = 0;				// Entries in watch_list
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: Watchpoint in the form KINDS:ADDR[-END][:ACTION], where KINDS
+//         is any of r (read), w (write) and c (value change), addresses
+//         are decimal or 0x hex, and ACTION is stop or dump
+// Outputs: 0 on success, -1 for a malformed watchpoint
+// /////////////////////////////////////////////////////////////////
+int watch_add(const char * spec) {
+    struct watchpoint wp;
+    const char * p;
+    char * end;
+    long first, last;
+    long addr;
+
+    if (watch_count >= MAX_WATCH) {
+	return -1;
+    }
+
+    wp.kinds = 0;
+    wp.action = WATCH_REPORT;
+    wp.hits = 0;
+
+    // Kinds of access
+    for (p = spec; *p && (*p != ':'); p++) {
+	switch (*p) {
+	    case 'r':
+		wp.kinds |= WATCH_READ;
+		break;
+	    case 'w':
+		wp.kinds |= WATCH_WRITE;
+		break;
+	    case 'c':
+		wp.kinds |= WATCH_CHANGE;
+		break;
+	    default:
+		return -1;
+	}
+    }
+    if ((wp.kinds == 0) || (*p != ':')) {
+	return -1;
+    }
+
+    // Address range, widened to whole words
+    first = strtol(p + 1, &end, 0);
+    last = first;
+    if (*end == '-') {
+	last = strtol(end + 1, &end, 0);
+    }
+    if ((end == p + 1) || (first < 0) || (last < first) || (last >= MEM_SIZE)) {
+	return -1;
+    }
+    first &= ~1L;
+    last |= 1L;
+
+    // Action
+    if (*end == ':') {
+	if (strcmp(end + 1, "stop") == 0) {
+	    wp.action = WATCH_STOP;
+	}
+	else if (strcmp(end + 1, "dump") == 0) {
+	    wp.action = WATCH_DUMP;
+	}
+	else {
+	    return -1;
+	}
+    }
+    else if (*end != '\0') {
+	return -1;
+    }
+
+    wp.first = first;
+    wp.last = last;
+    watch_list[watch_count++] = wp;
+
+    for (addr = first; addr <= last; addr++) {
+	watch_bitmap[addr >> 6] |= 1ULL << (addr & 63);
+    }
+
+    return 0;
+}
+
+// /////////////////////////////////////////////////////////////////
+// Inputs: WATCH_READ or WATCH_WRITE, word address, word before and after
+//         the access
+// Outputs: Non-zero if execution must stop
+// Description: Called when an access hits the shadow bitmap, reports
+//              every watchpoint that triggers
+// /////////////////////////////////////////////////////////////////
+int watch_hit(int kind, unsigned short int addr, short int old_value, short int new_value) {
+    char line[96];			// Formatted report
+    int stop;
+    int i;
+    int r;
+
+    stop = 0;
+
+    for (i = 0; i < watch_count; i++) {
+	if ((addr < watch_list[i].first) || (addr > watch_list[i].last)) {
+	    continue;
+	}
+	if (!(watch_list[i].kinds & kind) &&
+		!((kind == WATCH_WRITE) && (watch_list[i].kinds & WATCH_CHANGE) && (old_value != new_value))) {
+	    continue;
+	}
+
+	watch_list[i].hits++;
+
+	snprintf(line, sizeof(line), "Watchpoint %d: %s MEM[0x%04x] at PC 0x%04x: 0x%04x -> 0x%04x\n", i,
+		 (kind == WATCH_READ) ? "read" : "write", addr, program_counter,
+		 (unsigned short int)old_value, (unsigned short int)new_value);
+	*guest_out << line;
+
+	if (watch_list[i].action == WATCH_DUMP) {
+	    snprintf(line, sizeof(line), "  PC: 0x%04x", program_counter);
+	    *guest_out << line;
+	    for (r = 0; r < 8; r++) {
+		*guest_out << "  R" << r << ": " << reg_file[r];
+	    }
+	    *guest_out << "\n";
+	}
+	else if (watch_list[i].action == WATCH_STOP) {
+	    stop = 1;
+	}
+    }
+
+    if (stop) {
+	*guest_out << "Stopped by watchpoint...terminating" << endl;
+    }
+
+    return stop;
+}
@@ -0,0 +1,71 @@
+// ////////////////////////////////////////////////////////
+// File: branchstat.cpp
+// Description: Example instrumentation plugin. Counts taken and not
+//              taken branches and data memory traffic, and prints them
+//              when the simulation stops.
+//              Usage: xsim --plugin=bin/branchstat.so[:label] ...
+// Author: ZDHull
+// Date: 2026/10/19
+// ////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include "xplugin.h"
+
+// Counters kept by the plugin
+struct branch_stats {
+    char label[64];
+    unsigned long long taken;
+    unsigned long long not_taken;
+    unsigned long long reads;
+    unsigned long long writes;
+    unsigned long long silent_writes;	// Stores that did not change memory
+};
+
+static struct branch_stats stats;
+
+static void on_mem_read(void * data, unsigned short pc, unsigned short addr, short value) {
+    ((struct branch_stats *)data)->reads++;
+}
+
+static void on_mem_write(void * data, unsigned short pc, unsigned short addr, short old_value, short new_value) {
+    ((struct branch_stats *)data)->writes++;
+    if (old_value == new_value) {
+	((struct branch_stats *)data)->silent_writes++;
+    }
+}
+
+static void on_branch(void * data, unsigned short pc, unsigned short target, int taken) {
+    if (taken) {
+	((struct branch_stats *)data)->taken++;
+    }
+    else {
+	((struct branch_stats *)data)->not_taken++;
+    }
+}
+
+static void on_halt(void * data, const short * registers, const unsigned long long * clock_cycles) {
+    struct branch_stats * s = (struct branch_stats *)data;
+
+    printf("%s: %llu taken, %llu not taken, %llu reads, %llu writes (%llu silent)\n", s->label,
+	    s->taken, s->not_taken, s->reads, s->writes, s->silent_writes);
+}
+
+extern "C" int xsim_plugin_init(struct xsim_plugin * plugin, const char * args) {
+
+    if (plugin->version != XSIM_PLUGIN_VERSION) {
+	return -1;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    snprintf(stats.label, sizeof(stats.label), "%s", (args[0] != '\0') ? args : "branchstat");
+
+    // on_instruction is left empty and costs nothing but a test
+    plugin->data = &stats;
+    plugin->on_mem_read = on_mem_read;
+    plugin->on_mem_write = on_mem_write;
+    plugin->on_branch = on_branch;
+    plugin->on_halt = on_halt;
+
+    return 0;
+}
@@ -0,0 +1,445 @@
+// ////////////////////////////////////////////////////////
+// File: xsim-bench.cpp
+// Description: Simulator microbenchmarks. Generates one synthetic
+//              program per subsystem, runs each through libxsim with
+//              every engine, untimed warmup runs first, and prints
+//              guest MIPS, ns per instruction and program load time
+//              as JSON. Built and run by 'make bench'.
+// Author: ZDHull
+// Date: 2026/10/19
+// ////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <jsoncpp/json/json.h>
+#include "libxsim.h"
+
+using namespace std;
+
+// Iterations of each inner loop
+#define BENCH_INNER 8192
+// Outer loop iterations per unit of --scale
+#define BENCH_OUTER 12
+// Register holding 1 in every workload
+#define R_ONE 6
+
+// Instruction words of a program being generated
+typedef vector<unsigned short int> bench_program;
+
+// One synthetic workload
+struct bench_workload {
+    const char * name;			// Name in the report
+    const char * exercises;		// What it measures
+    void (*build)(bench_program & p, int scale);
+};
+
+// ////////////////////////////////////////////////////////
+// Encoders for the instruction formats
+// ////////////////////////////////////////////////////////
+static unsigned short int r_type(int op, int rd, int rs, int rt) {
+    return (op << 11) | (rd << 8) | (rs << 5) | (rt << 2);
+}
+
+static unsigned short int i_type(int op, int rd, int imm8) {
+    return (op << 11) | (rd << 8) | (imm8 & 0x00FF);
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Program, instruction word
+// Outputs: Address of the instruction
+// ////////////////////////////////////////////////////////
+static unsigned int emit(bench_program & p, unsigned short int inst) {
+
+    p.push_back(inst);
+
+    return (p.size() - 1) * 2;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Program, register, 16-bit value
+// Outputs: Address of the first of the two instructions
+// ////////////////////////////////////////////////////////
+static unsigned int emit_const(bench_program & p, int rd, unsigned int value) {
+    unsigned int addr;
+
+    addr = emit(p, i_type(0x10, rd, value & 0x00FF));
+    emit(p, i_type(0x12, rd, (value >> 8) & 0x00FF));
+
+    return addr;
+}
+
+// Points a branch emitted earlier at target, which must be below 512
+static void patch_branch(bench_program & p, unsigned int at, unsigned int target) {
+
+    p[at / 2] = (p[at / 2] & 0xFF00) | ((target >> 1) & 0x00FF);
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Program, scale
+// Outputs: Address of the outer loop, and returned, of the inner
+//          loop body
+// Description: Opens the two nested loops every workload runs its
+//              body in: R5 counts outer and R7 inner iterations.
+//              loop_close() ends them and halts.
+// ////////////////////////////////////////////////////////
+static unsigned int loop_open(bench_program & p, int scale, unsigned int * outer) {
+
+    emit_const(p, R_ONE, 1);
+    emit_const(p, 5, BENCH_OUTER * scale);
+    *outer = emit_const(p, 7, BENCH_INNER);
+
+    return p.size() * 2;
+}
+
+static void loop_close(bench_program & p, unsigned int outer, unsigned int inner) {
+
+    emit(p, r_type(0x01, 7, 7, R_ONE));
+    emit(p, i_type(0x16, 7, inner >> 1));
+    emit(p, r_type(0x01, 5, 5, R_ONE));
+    emit(p, i_type(0x16, 5, outer >> 1));
+    emit(p, r_type(0x0D, 0, 0, 0));
+}
+
+// ////////////////////////////////////////////////////////
+// Workloads
+// ////////////////////////////////////////////////////////
+
+// ADD, SUB, AND and NOR with a dependence chain through R0-R3
+static void build_alu(bench_program & p, int scale) {
+    unsigned int outer, inner;
+
+    emit_const(p, 1, 0x1234);
+    emit_const(p, 2, 0x0F0F);
+    inner = loop_open(p, scale, &outer);
+    emit(p, r_type(0x00, 0, 0, 1));
+    emit(p, r_type(0x01, 3, 0, 2));
+    emit(p, r_type(0x02, 1, 3, 2));
+    emit(p, r_type(0x03, 2, 1, 0));
+    emit(p, r_type(0x00, 1, 1, 3));
+    emit(p, r_type(0x01, 2, 2, R_ONE));
+    emit(p, r_type(0x02, 3, 3, 1));
+    emit(p, r_type(0x03, 0, 0, 2));
+    loop_close(p, outer, inner);
+}
+
+// DIV, MOD, MUL and EXP, divisors never zero
+static void build_divmod(bench_program & p, int scale) {
+    unsigned int outer, inner;
+
+    emit_const(p, 1, 1000);
+    emit_const(p, 2, 7);
+    emit_const(p, 3, 3);
+    inner = loop_open(p, scale, &outer);
+    emit(p, r_type(0x04, 0, 1, 2));
+    emit(p, r_type(0x06, 4, 1, 2));
+    emit(p, r_type(0x05, 0, 0, 3));
+    emit(p, r_type(0x07, 4, 2, 3));
+    emit(p, r_type(0x04, 0, 1, 3));
+    emit(p, r_type(0x06, 4, 0, 2));
+    emit(p, r_type(0x00, 1, 1, R_ONE));
+    loop_close(p, outer, inner);
+}
+
+// LW and SW streaming through all of data memory, R4 wraps at 64 KB
+static void build_memory(bench_program & p, int scale) {
+    unsigned int outer, inner;
+    int i;
+
+    emit_const(p, 3, 2);
+    emit_const(p, 4, 0);
+    inner = loop_open(p, scale, &outer);
+    for (i = 0; i < 2; i++) {
+	emit(p, r_type(0x08, 1, 4, 0));
+	emit(p, r_type(0x00, 1, 1, R_ONE));
+	emit(p, r_type(0x09, 0, 4, 1));
+	emit(p, r_type(0x00, 4, 4, 3));
+    }
+    loop_close(p, outer, inner);
+}
+
+// Conditional branches, half of them alternating taken and not taken
+static void build_branch(bench_program & p, int scale) {
+    unsigned int outer, inner;
+    unsigned int branch;		// Branch waiting for its target
+
+    emit_const(p, 2, 0);
+    inner = loop_open(p, scale, &outer);
+    emit(p, r_type(0x03, 2, 2, 2));
+    branch = emit(p, i_type(0x15, 2, 0));
+    emit(p, r_type(0x00, 0, 0, R_ONE));
+    patch_branch(p, branch, p.size() * 2);
+    branch = emit(p, i_type(0x17, 2, 0));
+    emit(p, r_type(0x01, 0, 0, R_ONE));
+    patch_branch(p, branch, p.size() * 2);
+    branch = emit(p, i_type(0x16, R_ONE, 0));
+    emit(p, r_type(0x00, 1, 1, R_ONE));
+    patch_branch(p, branch, p.size() * 2);
+    branch = emit(p, i_type(0x14, R_ONE, 0));
+    emit(p, r_type(0x00, 1, 1, R_ONE));
+    patch_branch(p, branch, p.size() * 2);
+    loop_close(p, outer, inner);
+}
+
+// JALR to a leaf function returning with JR
+static void build_call(bench_program & p, int scale) {
+    unsigned int outer, inner;
+    int i;
+
+    // Jump over the function at address 2
+    emit(p, (0x18 << 11) | 3);
+    emit(p, r_type(0x00, 1, 1, R_ONE));
+    emit(p, r_type(0x0C, 0, 4, 0));
+
+    emit_const(p, 3, 2);
+    inner = loop_open(p, scale, &outer);
+    for (i = 0; i < 4; i++) {
+	emit(p, r_type(0x13, 4, 3, 0));
+    }
+    loop_close(p, outer, inner);
+}
+
+// All of instruction memory: ADDs of R0 falling through to a HALT
+static void build_load(bench_program & p, int scale) {
+
+    p.assign(32767, r_type(0x00, 0, 0, 0));
+    emit(p, r_type(0x0D, 0, 0, 0));
+}
+
+static const struct bench_workload workloads[] = {
+    {"alu", "add sub and nor", build_alu},
+    {"divmod", "div mod mul exp", build_divmod},
+    {"memory", "lw sw streaming over 64 KB", build_memory},
+    {"branch", "bp bn bx bz", build_branch},
+    {"call", "jalr jr", build_call},
+    {"load", "loading a 64 KB program", build_load}
+};
+
+// ////////////////////////////////////////////////////////
+// Outputs: Seconds on the monotonic clock
+// ////////////////////////////////////////////////////////
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Times of the timed iterations
+// Outputs: Their min, median and mean
+// ////////////////////////////////////////////////////////
+static Json::Value summarize(vector<double> times) {
+    Json::Value obj;
+    double sum = 0;
+    unsigned int i;
+
+    sort(times.begin(), times.end());
+    for (i = 0; i < times.size(); i++) {
+	sum += times[i];
+    }
+    obj["min"] = times[0];
+    obj["median"] = (times.size() & 1) ? times[times.size() / 2] :
+		    (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2;
+    obj["mean"] = sum / times.size();
+
+    return obj;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Simulator, workload, engine, scale, warmup and timed
+//         iterations
+// Outputs: Report of the workload, null if it did not halt
+// ////////////////////////////////////////////////////////
+static Json::Value bench_one(xsim * x, const struct bench_workload * w, int engine, int scale, int warmup, int iterations) {
+    struct xsim_config config;		// Engine to measure
+    struct xsim_stats stats;		// Instructions of one run
+    bench_program p;			// Generated program
+    vector<unsigned char> binary;	// Program as instruction memory
+    string text;			// Program as a program file
+    vector<double> load_times;		// Seconds to parse the text
+    vector<double> binary_times;	// Seconds to copy the binary
+    vector<double> run_times;		// Seconds to run
+    Json::Value obj;
+    double start;
+    char line[8];
+    unsigned int i;
+    int k;
+
+    w->build(p, scale);
+    for (i = 0; i < p.size(); i++) {
+	snprintf(line, sizeof(line), "%04X\n", p[i]);
+	text += line;
+	binary.push_back(p[i] >> 8);
+	binary.push_back(p[i] & 0x00FF);
+    }
+
+    xsim_default_config(&config);
+    config.engine = engine;
+    xsim_configure(x, &config);
+
+    for (k = 0; k < warmup + iterations; k++) {
+	start = now();
+	xsim_load(x, text.data(), text.size());
+	if (k >= warmup) {
+	    load_times.push_back(now() - start);
+	}
+
+	start = now();
+	xsim_load_binary(x, binary.data(), binary.size());
+	if (k >= warmup) {
+	    binary_times.push_back(now() - start);
+	}
+
+	start = now();
+	if (xsim_run(x) != XSIM_HALTED) {
+	    cerr << "Workload " << w->name << " did not halt...terminating" << endl;
+	    return Json::Value();
+	}
+	if (k >= warmup) {
+	    run_times.push_back(now() - start);
+	}
+    }
+
+    xsim_stats(x, &stats);
+
+    obj["workload"] = w->name;
+    obj["exercises"] = w->exercises;
+    obj["engine"] = (engine == XSIM_ENGINE_FAST) ? "fast" : "reference";
+    obj["program_bytes"] = (Json::UInt64)binary.size();
+    obj["instructions"] = (Json::UInt64)stats.instructions;
+    obj["run_seconds"] = summarize(run_times);
+    obj["load_seconds"] = summarize(load_times);
+    obj["load_binary_seconds"] = summarize(binary_times);
+    obj["mips"] = stats.instructions / obj["run_seconds"]["median"].asDouble() / 1e6;
+    obj["ns_per_instruction"] = obj["run_seconds"]["median"].asDouble() * 1e9 / stats.instructions;
+
+    return obj;
+}
+
+static void print_usage(char * program) {
+    cout << "Usage: " << program << " [options]" << endl;
+    cout << "\t--scale=N\t\tRun about N million instructions per loop workload (default 10)" << endl;
+    cout << "\t--warmup=N\t\tUntimed runs before measuring (default 1)" << endl;
+    cout << "\t--iterations=N\t\tTimed runs (default 5)" << endl;
+    cout << "\t--engine=E\t\treference, fast or both (default both)" << endl;
+    cout << "\t--only=NAME\t\tRun one workload" << endl;
+    cout << "\t--output=FILE\t\tWrite the report to FILE instead of stdout" << endl;
+}
+
+int main(int argc, char * argv[]) {
+    int scale = 10;			// Outer loop multiplier
+    int warmup = 1;			// Untimed runs
+    int iterations = 5;			// Timed runs
+    int engines[2];			// Engines to measure
+    int engine_count;
+    const char * only = 0;		// Single workload to run
+    const char * output = 0;		// Report file
+    Json::Value report;			// Everything measured
+    Json::Value result;
+    Json::StyledWriter styledWriter;
+    ofstream outfile;
+    xsim * x;
+    unsigned int i;
+    int e;
+    int option;
+
+    static struct option long_options[] = {
+	{"scale", required_argument, 0, 's'},
+	{"warmup", required_argument, 0, 'w'},
+	{"iterations", required_argument, 0, 'n'},
+	{"engine", required_argument, 0, 'e'},
+	{"only", required_argument, 0, 'o'},
+	{"output", required_argument, 0, 'f'},
+	{0, 0, 0, 0}
+    };
+
+    engines[0] = XSIM_ENGINE_REFERENCE;
+    engines[1] = XSIM_ENGINE_FAST;
+    engine_count = 2;
+
+    while ((option = getopt_long(argc, argv, "", long_options, 0)) != -1) {
+	switch (option) {
+	    case 's':
+		scale = atoi(optarg);
+		break;
+	    case 'w':
+		warmup = atoi(optarg);
+		break;
+	    case 'n':
+		iterations = atoi(optarg);
+		break;
+	    case 'e':
+		engine_count = 1;
+		if (strcmp(optarg, "reference") == 0) {
+		    engines[0] = XSIM_ENGINE_REFERENCE;
+		}
+		else if (strcmp(optarg, "fast") == 0) {
+		    engines[0] = XSIM_ENGINE_FAST;
+		}
+		else if (strcmp(optarg, "both") == 0) {
+		    engine_count = 2;
+		}
+		else {
+		    print_usage(argv[0]);
+		    return -1;
+		}
+		break;
+	    case 'o':
+		only = optarg;
+		break;
+	    case 'f':
+		output = optarg;
+		break;
+	    default:
+		print_usage(argv[0]);
+		return -1;
+	}
+    }
+
+    // The outer loop count is 16 bits
+    if ((scale < 1) || (BENCH_OUTER * scale > 0xFFFF) || (warmup < 0) || (iterations < 1) || (optind != argc)) {
+	print_usage(argv[0]);
+	return -1;
+    }
+
+    x = xsim_create();
+
+    report["scale"] = scale;
+    report["warmup"] = warmup;
+    report["iterations"] = iterations;
+    report["results"] = Json::Value(Json::arrayValue);
+    for (i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+	if (only && strcmp(only, workloads[i].name)) {
+	    continue;
+	}
+	for (e = 0; e < engine_count; e++) {
+	    result = bench_one(x, &workloads[i], engines[e], scale, warmup, iterations);
+	    if (result.isNull()) {
+		return -1;
+	    }
+	    report["results"].append(result);
+	}
+    }
+
+    xsim_destroy(x);
+
+    if (output) {
+	outfile.open(output);
+	outfile << styledWriter.write(report);
+	outfile.close();
+    }
+    else {
+	cout << styledWriter.write(report);
+    }
+
+    return 0;
+}
@@ -0,0 +1,565 @@
+// ////////////////////////////////////////////////////////
+// File: xsim-check.cpp
+// Description: Conformance and performance regression gate. Runs
+//              every program in the test directory with every
+//              test/config_*.json on the reference engine and on the
+//              fast engine with and without memoization, in parallel
+//              through libxsim, and fails when
+//                - registers or stats differ from the golden output
+//                  file in test/golden (written by the reference
+//                  engine with --update-golden), or
+//                - a run is slower than the stored baseline by more
+//                  than the tolerance and a one-sided Welch t-test
+//                  says the slowdown is significant.
+//              Built and run by 'make check'.
+// Author: ZDHull
+// Date: 2026/10/19
+// ////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <glob.h>
+#include <getopt.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <jsoncpp/json/json.h>
+#include "libxsim.h"
+
+using namespace std;
+
+// Shortest timed sample; runs are repeated until it is reached
+#define CHECK_SAMPLE_SECONDS 0.002
+// Instructions before a program is taken not to stop
+#define CHECK_MAX_INSTRUCTIONS 10000000
+// Memo table of the memoize cases, the size --memoize uses by default
+#define CHECK_MEMOIZE_KB 1024
+
+// Latencies in the order of xsim_config.latency
+static const char * latency_names[8] = {"add", "sub", "and", "nor", "div", "mul", "mod", "exp"};
+static const char * engine_names[3] = {"reference", "fast", "memoize"};
+
+// One program, configuration and engine
+struct check_case {
+    string name;			// program/config/engine
+    string program;			// Program file name
+    string text;			// Program file
+    string golden;			// Golden output file name
+    int latency[8];			// Latencies of the configuration
+    int engine;				// Index into engine_names
+    // Results
+    int status;				// Of the last run
+    struct xsim_registers regs;
+    struct xsim_stats stats;
+    int reps;				// Runs per timed sample
+    vector<double> samples;		// Seconds per run
+};
+
+// Settings from the command line
+static string test_dir = "test";	// Programs, configurations, golden/
+static int samples = 10;		// Timed samples per case
+static double tolerance = 0.10;		// Slowdown allowed without failing
+static double alpha = 0.01;		// Significance of the t-test
+static int perf_enabled = 1;		// Compare against the baseline
+
+// ////////////////////////////////////////////////////////
+// Outputs: Seconds on the monotonic clock
+// ////////////////////////////////////////////////////////
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: File name, destination
+// Outputs: 0 when the file was read
+// ////////////////////////////////////////////////////////
+static int read_file(const string & name, string & text) {
+    ifstream in(name.c_str());
+    stringstream buffer;
+
+    if (!in.is_open()) {
+	return -1;
+    }
+    buffer << in.rdbuf();
+    text = buffer.str();
+
+    return 0;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: File name, destination
+// Outputs: 0 when the file was read and parsed
+// ////////////////////////////////////////////////////////
+static int read_json(const string & name, Json::Value & root) {
+    Json::CharReaderBuilder builder;
+    string errors;
+    ifstream in(name.c_str());
+
+    if (!in.is_open()) {
+	return -1;
+    }
+
+    return Json::parseFromStream(builder, in, &root, &errors) ? 0 : -1;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: glob(3) pattern
+// Outputs: Matching file names, sorted
+// ////////////////////////////////////////////////////////
+static vector<string> list_files(const string & pattern) {
+    vector<string> names;
+    glob_t found;
+    size_t i;
+
+    if (glob(pattern.c_str(), 0, 0, &found) == 0) {
+	for (i = 0; i < found.gl_pathc; i++) {
+	    names.push_back(found.gl_pathv[i]);
+	}
+    }
+    globfree(&found);
+
+    return names;
+}
+
+// File name without directory or extension, and without prefix
+static string base_name(const string & name, const char * prefix) {
+    string base;
+
+    base = name.substr(name.rfind('/') + 1);
+    base = base.substr(0, base.rfind('.'));
+    if (base.compare(0, strlen(prefix), prefix) == 0) {
+	base = base.substr(strlen(prefix));
+    }
+
+    return base;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Case that was run
+// Outputs: Its registers and stats in the output file layout
+// ////////////////////////////////////////////////////////
+static Json::Value case_output(const struct check_case & c) {
+    Json::Value array;
+    Json::Value reg_obj;
+    Json::Value stat_obj;
+    char name[4];
+    int i;
+
+    for (i = 0; i < 8; i++) {
+	snprintf(name, sizeof(name), "r%d", i);
+	reg_obj[name] = c.regs.r[i];
+    }
+    for (i = 0; i < XSIM_STATS; i++) {
+	stat_obj[xsim_stat_name(i)] = (Json::UInt64)c.stats.count[i];
+    }
+    stat_obj["instructions"] = (Json::UInt64)c.stats.instructions;
+    stat_obj["cycles"] = (Json::UInt64)c.stats.cycles;
+
+    array["registers"].append(reg_obj);
+    array["stats"].append(stat_obj);
+
+    return array;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Case that was run, golden output file
+// Outputs: Non-zero when every register and stat matches
+// ////////////////////////////////////////////////////////
+static int case_matches(const struct check_case & c, const Json::Value & golden) {
+    const Json::Value & regs = golden["registers"][0];
+    const Json::Value & stats = golden["stats"][0];
+    char name[4];
+    int i;
+
+    if (!regs.isObject() || !stats.isObject()) {
+	return 0;
+    }
+    for (i = 0; i < 8; i++) {
+	snprintf(name, sizeof(name), "r%d", i);
+	if (!regs[name].isInt() || (regs[name].asInt() != c.regs.r[i])) {
+	    return 0;
+	}
+    }
+    for (i = 0; i < XSIM_STATS; i++) {
+	if (stats[xsim_stat_name(i)].asUInt64() != c.stats.count[i]) {
+	    return 0;
+	}
+    }
+
+    return (stats["instructions"].asUInt64() == c.stats.instructions) && (stats["cycles"].asUInt64() == c.stats.cycles);
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Case, its simulator
+// Description: Runs the case once for its results, then times
+//              samples of reps back-to-back runs
+// ////////////////////////////////////////////////////////
+static void run_case(xsim * x, struct check_case & c) {
+    struct xsim_config config;
+    double start;
+    double elapsed;
+    int i, k;
+
+    xsim_default_config(&config);
+    memcpy(config.latency, c.latency, sizeof(config.latency));
+    config.engine = c.engine ? XSIM_ENGINE_FAST : XSIM_ENGINE_REFERENCE;
+    config.memoize_kb = (c.engine == 2) ? CHECK_MEMOIZE_KB : 0;
+    config.max_instructions = CHECK_MAX_INSTRUCTIONS;
+    xsim_configure(x, &config);
+    xsim_load(x, c.text.data(), c.text.size());
+
+    c.status = xsim_run(x);
+    xsim_registers(x, &c.regs);
+    xsim_stats(x, &c.stats);
+
+    if (!perf_enabled) {
+	return;
+    }
+
+    // Enough runs per sample to rise above the clock resolution
+    for (c.reps = 1; ; c.reps *= 2) {
+	elapsed = 0;
+	for (k = 0; k < c.reps; k++) {
+	    xsim_reset(x);
+	    start = now();
+	    xsim_run(x);
+	    elapsed += now() - start;
+	}
+	if ((elapsed >= CHECK_SAMPLE_SECONDS) || (c.reps >= (1 << 20))) {
+	    break;
+	}
+    }
+
+    for (i = 0; i < samples; i++) {
+	elapsed = 0;
+	for (k = 0; k < c.reps; k++) {
+	    xsim_reset(x);
+	    start = now();
+	    xsim_run(x);
+	    elapsed += now() - start;
+	}
+	c.samples.push_back(elapsed / c.reps);
+    }
+
+    return;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: a, b > 0 and 0 <= x <= 1
+// Outputs: Regularized incomplete beta function I_x(a, b)
+// Description: Continued fraction by the modified Lentz method
+// ////////////////////////////////////////////////////////
+static double incomplete_beta(double a, double b, double x) {
+    double front, f, c, d, numerator;
+    int i, m;
+
+    if ((x <= 0) || (x >= 1)) {
+	return (x <= 0) ? 0 : 1;
+    }
+    // The fraction converges for x below the mean
+    if (x > (a + 1) / (a + b + 2)) {
+	return 1 - incomplete_beta(b, a, 1 - x);
+    }
+
+    front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1 - x)) / a;
+
+    f = 1e-30;
+    c = 1e-30;
+    d = 0;
+    for (i = 0; i <= 400; i++) {
+	m = i / 2;
+	if (i == 0) {
+	    numerator = 1;
+	}
+	else if (i & 1) {
+	    numerator = -((a + m) * (a + b + m) * x) / ((a + 2 * m) * (a + 2 * m + 1));
+	}
+	else {
+	    numerator = (m * (b - m) * x) / ((a + 2 * m - 1) * (a + 2 * m));
+	}
+	d = 1 + numerator * d;
+	d = (fabs(d) < 1e-30) ? 1e-30 : d;
+	d = 1 / d;
+	c = 1 + numerator / c;
+	c = (fabs(c) < 1e-30) ? 1e-30 : c;
+	f *= c * d;
+	if (fabs(1 - c * d) < 1e-12) {
+	    break;
+	}
+    }
+
+    return front * (f - 1);
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Mean, variance and size of the baseline and the current
+//         samples
+// Outputs: p-value of the current runs being no slower, by a
+//          one-sided Welch t-test
+// ////////////////////////////////////////////////////////
+static double welch_p(double base_mean, double base_var, int base_n, double mean, double var, int n) {
+    double se;				// Standard error of the difference
+    double t;
+    double df;				// Welch-Satterthwaite degrees of freedom
+
+    se = base_var / base_n + var / n;
+    if (se <= 0) {
+	return (mean > base_mean) ? 0 : 1;
+    }
+    t = (mean - base_mean) / sqrt(se);
+    df = se * se / ((base_var / base_n) * (base_var / base_n) / (base_n - 1) + (var / n) * (var / n) / (n - 1));
+
+    if (t <= 0) {
+	return 1 - 0.5 * incomplete_beta(df / 2, 0.5, df / (df + t * t));
+    }
+
+    return 0.5 * incomplete_beta(df / 2, 0.5, df / (df + t * t));
+}
+
+// Mean and sample variance
+static void moments(const vector<double> & v, double * mean, double * var) {
+    size_t i;
+
+    *mean = 0;
+    *var = 0;
+    for (i = 0; i < v.size(); i++) {
+	*mean += v[i];
+    }
+    *mean /= v.size();
+    for (i = 0; i < v.size(); i++) {
+	*var += (v[i] - *mean) * (v[i] - *mean);
+    }
+    *var = (v.size() > 1) ? *var / (v.size() - 1) : 0;
+
+    return;
+}
+
+static void print_usage(char * program) {
+    cout << "Usage: " << program << " [options]" << endl;
+    cout << "\t--jobs=N\t\tCases run at once (default one per core)" << endl;
+    cout << "\t--samples=N\t\tTimed samples per case (default 10)" << endl;
+    cout << "\t--tolerance=F\t\tSlowdown allowed, 0.10 is 10% (default 0.10)" << endl;
+    cout << "\t--alpha=F\t\tSignificance level of the t-test (default 0.01)" << endl;
+    cout << "\t--no-perf\t\tOnly check results" << endl;
+    cout << "\t--update-golden\t\tWrite the reference engine's results as the golden outputs" << endl;
+    cout << "\t--update-baseline\tWrite the timings as the performance baseline" << endl;
+    cout << "\t--test-dir=DIR\t\tPrograms and configurations (default test)" << endl;
+}
+
+int main(int argc, char * argv[]) {
+    vector<struct check_case> cases;	// Everything to run
+    vector<string> programs;		// Program files
+    vector<string> configs;		// Configuration files
+    vector<thread> workers;		// Threads running cases
+    atomic<unsigned int> next_case(0);	// Next case to take
+    Json::Value config;			// Parsed configuration
+    Json::Value golden;			// Expected output
+    Json::Value baseline;		// Timings to compare against
+    Json::Value entry;
+    Json::StyledWriter styledWriter;
+    ofstream outfile;
+    string baseline_file;
+    string text;
+    struct check_case c;
+    double mean, var, base_mean, base_var, p;
+    int jobs = 0;			// Threads
+    int update_golden = 0;
+    int update_baseline = 0;
+    int failures = 0;
+    int slower;
+    unsigned int i, j;
+    int e, k;
+    int option;
+
+    static struct option long_options[] = {
+	{"jobs", required_argument, 0, 'j'},
+	{"samples", required_argument, 0, 'n'},
+	{"tolerance", required_argument, 0, 't'},
+	{"alpha", required_argument, 0, 'a'},
+	{"no-perf", no_argument, 0, 'q'},
+	{"update-golden", no_argument, 0, 'g'},
+	{"update-baseline", no_argument, 0, 'b'},
+	{"test-dir", required_argument, 0, 'd'},
+	{0, 0, 0, 0}
+    };
+
+    while ((option = getopt_long(argc, argv, "", long_options, 0)) != -1) {
+	switch (option) {
+	    case 'j':
+		jobs = atoi(optarg);
+		break;
+	    case 'n':
+		samples = atoi(optarg);
+		break;
+	    case 't':
+		tolerance = atof(optarg);
+		break;
+	    case 'a':
+		alpha = atof(optarg);
+		break;
+	    case 'q':
+		perf_enabled = 0;
+		break;
+	    case 'g':
+		update_golden = 1;
+		break;
+	    case 'b':
+		update_baseline = 1;
+		break;
+	    case 'd':
+		test_dir = optarg;
+		break;
+	    default:
+		print_usage(argv[0]);
+		return -1;
+	}
+    }
+    if ((samples < 2) || (tolerance < 0) || (alpha <= 0) || (alpha >= 1) || (optind != argc)) {
+	print_usage(argv[0]);
+	return -1;
+    }
+    if (update_baseline) {
+	perf_enabled = 1;
+    }
+    if (jobs <= 0) {
+	jobs = thread::hardware_concurrency() ? thread::hardware_concurrency() : 1;
+    }
+
+    // One case per program, configuration and engine
+    programs = list_files(test_dir + "/*.txt");
+    configs = list_files(test_dir + "/config_*.json");
+    for (i = 0; i < programs.size(); i++) {
+	if (read_file(programs[i], text) != 0) {
+	    cout << "Unable to read " << programs[i] << "...terminating" << endl;
+	    return -1;
+	}
+	for (j = 0; j < configs.size(); j++) {
+	    if (read_json(configs[j], config) != 0) {
+		cout << "Unable to parse " << configs[j] << "...terminating" << endl;
+		return -1;
+	    }
+	    for (e = 0; e < 3; e++) {
+		c.program = programs[i];
+		c.text = text;
+		c.name = base_name(programs[i], "") + "/" + base_name(configs[j], "config_") + "/" + engine_names[e];
+		c.golden = test_dir + "/golden/" + base_name(programs[i], "") + "-" + base_name(configs[j], "config_") + ".json";
+		for (k = 0; k < 8; k++) {
+		    c.latency[k] = config.get(latency_names[k], 1).asInt();
+		}
+		c.engine = e;
+		cases.push_back(c);
+	    }
+	}
+    }
+    if (cases.empty()) {
+	cout << "No programs and configurations in " << test_dir << "...terminating" << endl;
+	return -1;
+    }
+
+    // Timings are only taken when there is something to compare them to
+    baseline_file = test_dir + "/golden/baseline.json";
+    if (perf_enabled && !update_baseline) {
+	if (read_json(baseline_file, baseline) != 0) {
+	    cout << "No baseline in " << baseline_file << ", run with --update-baseline" << endl;
+	    perf_enabled = 0;
+	}
+	else if (baseline["jobs"].asInt() != jobs) {
+	    cout << "Baseline was taken with --jobs=" << baseline["jobs"].asInt() << ", timings may not compare" << endl;
+	}
+    }
+
+    // Each thread has its own simulator
+    for (k = 0; k < jobs; k++) {
+	workers.push_back(thread([&cases, &next_case] {
+	    xsim * x = xsim_create();
+	    unsigned int n;
+
+	    while ((n = next_case++) < cases.size()) {
+		run_case(x, cases[n]);
+	    }
+	    xsim_destroy(x);
+	}));
+    }
+    for (k = 0; k < jobs; k++) {
+	workers[k].join();
+    }
+
+    for (i = 0; i < cases.size(); i++) {
+	const struct check_case & r = cases[i];
+
+	if (update_golden && (r.engine == 0)) {
+	    outfile.open(r.golden.c_str());
+	    outfile << styledWriter.write(case_output(r));
+	    outfile.close();
+	}
+
+	// Results, programs that stop on an error included
+	if ((r.status != XSIM_HALTED) && (r.status != XSIM_FAULT)) {
+	    cout << "FAIL " << r.name << ": did not stop within " << CHECK_MAX_INSTRUCTIONS << " instructions" << endl;
+	    failures++;
+	    continue;
+	}
+	if (read_json(r.golden, golden) != 0) {
+	    cout << "FAIL " << r.name << ": no golden output " << r.golden << endl;
+	    failures++;
+	    continue;
+	}
+	if (!case_matches(r, golden)) {
+	    cout << "FAIL " << r.name << ": registers or stats differ from " << r.golden << endl;
+	    failures++;
+	    continue;
+	}
+
+	if (!perf_enabled) {
+	    cout << "PASS " << r.name << endl;
+	    continue;
+	}
+
+	// Performance
+	moments(r.samples, &mean, &var);
+	if (update_baseline) {
+	    entry["mean"] = mean;
+	    entry["stddev"] = sqrt(var);
+	    entry["samples"] = (int)r.samples.size();
+	    entry["mips"] = r.stats.instructions / mean / 1e6;
+	    baseline["cases"][r.name] = entry;
+	    printf("PASS %s: %.3f us, %.1f MIPS\n", r.name.c_str(), mean * 1e6, r.stats.instructions / mean / 1e6);
+	    continue;
+	}
+	entry = baseline["cases"][r.name];
+	if (entry.isNull()) {
+	    printf("PASS %s: %.3f us, %.1f MIPS, not in the baseline\n", r.name.c_str(), mean * 1e6, r.stats.instructions / mean / 1e6);
+	    continue;
+	}
+	base_mean = entry["mean"].asDouble();
+	base_var = entry["stddev"].asDouble() * entry["stddev"].asDouble();
+	p = welch_p(base_mean, base_var, entry["samples"].asInt(), mean, var, r.samples.size());
+	slower = (mean > base_mean * (1 + tolerance)) && (p < alpha);
+	printf("%s %s: %.3f us vs %.3f us (%+.1f%%, p=%.4f), %.1f MIPS\n", slower ? "SLOW" : "PASS", r.name.c_str(),
+	       mean * 1e6, base_mean * 1e6, 100 * (mean / base_mean - 1), p, r.stats.instructions / mean / 1e6);
+	failures += slower;
+    }
+
+    if (update_baseline) {
+	baseline["jobs"] = jobs;
+	outfile.open(baseline_file.c_str());
+	outfile << styledWriter.write(baseline);
+	outfile.close();
+    }
+
+    cout << cases.size() - failures << " of " << cases.size() << " cases passed" << endl;
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,558 @@
+// ////////////////////////////////////////////////////////
+// File: xsim-fuzz.cpp
+// Description: Differential fuzzer for the execution engines. Each
+//              worker thread generates random programs, initial data
+//              memory and instruction limits from a seed, runs them on
+//              the reference engine and on the fast engine with and
+//              without memoization through libxsim, and compares
+//              status, PC, registers, every clock_cycles counter, data
+//              memory and guest output. Programs are loaded once per
+//              engine and runs start from xsim_reset, so nothing is
+//              spawned or written to disk until a mismatch is found.
+//              A mismatch is shrunk to a small program and written out
+//              as files the xsim command line can run.
+// Author: ZDHull
+// Date: 2026/10/19
+// ////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+#include "libxsim.h"
+
+using namespace std;
+
+// Longest instruction limit given to a program
+#define FUZZ_MAX_INSTRUCTIONS 10000
+// Programs between checks of the time limit and stop flag
+#define FUZZ_BATCH 64
+
+// A generated program with everything its run depends on
+struct fuzz_case {
+    vector<unsigned short int> code;	// Instruction words
+    vector<unsigned short int> data;	// Initial words at data_addr
+    vector<unsigned short int> data_addr;	// Even addresses in bank 0
+    long long limit;			// Instruction limit
+    unsigned int banks;			// Data memory banks
+    int perf;				// --perf-isa instructions enabled
+};
+
+// What a run leaves behind
+struct fuzz_result {
+    int status;
+    struct xsim_registers regs;
+    struct xsim_stats stats;
+    unsigned long long digest;		// Of data memory
+    string output;			// Guest output
+};
+
+// Engines compared against the reference engine
+static const char * engine_names[3] = {"reference", "fast", "memoize"};
+
+static atomic<unsigned long long> next_seed;	// Seed of the next program
+static atomic<unsigned long long> programs_run(0);	// Programs compared
+static atomic<int> stop(0);			// A worker found a mismatch
+static mutex report_lock;			// One report at a time
+
+// ////////////////////////////////////////////////////////
+// Outputs: Seconds on the monotonic clock
+// ////////////////////////////////////////////////////////
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Seed, case to fill in
+// Description: Random mix of every instruction, invalid opcodes
+//              included, with branches and jumps inside the program
+//              and counted, fill and copy loops the fast engine runs
+//              without stepping through them
+// ////////////////////////////////////////////////////////
+static void fuzz_generate(unsigned long long seed, struct fuzz_case & c) {
+    mt19937_64 rng(seed);
+    unsigned int n;			// Instructions before the final HALT
+    unsigned int start;			// First word of a loop
+    unsigned int target;		// Word a branch goes to
+    unsigned int i, k;
+    double kind;
+    int op;
+
+    auto reg = [&rng]() { return (int)(rng() & 0x0007); };
+    auto below = [&rng](unsigned int limit) { return (unsigned int)(rng() % limit); };
+    auto chance = [&rng]() { return (rng() >> 11) * (1.0 / 9007199254740992.0); };
+    static const int alu_ops[10] = {0x00, 0x01, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+    static const int invalid_ops[3] = {0x0A, 0x0F, 0x1B};
+    static const int perf_ops[4] = {0x0A, 0x0B, 0x0F, 0x19};
+
+    c.code.clear();
+    c.data.clear();
+    c.data_addr.clear();
+
+    // A quarter of the runs read counters, whose values depend on
+    // every instruction before them
+    c.perf = (chance() < 0.25);
+
+    n = 5 + below(56);
+    for (i = 0; c.code.size() < n; i++) {
+	kind = chance();
+	if (kind < 0.30) {
+	    int rd = reg(), rs = reg(), rt = reg();
+	    if (chance() < 0.5) {
+		rs = rd;
+	    }
+	    c.code.push_back((alu_ops[below(10)] << 11) | (rd << 8) | (rs << 5) | (rt << 2));
+	}
+	else if (kind < 0.50) {
+	    op = 0x10 + below(3);
+	    c.code.push_back((op << 11) | (reg() << 8) | below(256));
+	}
+	else if (kind < 0.60) {
+	    op = 0x08 + below(2);
+	    c.code.push_back((op << 11) | (reg() << 8) | (reg() << 5) | (reg() << 2));
+	}
+	else if (kind < 0.78) {
+	    op = 0x14 + below(4);
+	    target = below(n);
+	    if (chance() < 0.5) {
+		target = c.code.size() - min((unsigned int)c.code.size(), below(5));
+	    }
+	    c.code.push_back((op << 11) | (reg() << 8) | target);
+	}
+	else if (kind < 0.82) {
+	    // Fill or copy loop: R4 stores, R3 loads, both stepped by R6
+	    // (a word up or down), R7 counts down by R5
+	    c.code.push_back((0x11 << 11) | (6 << 8) | ((chance() < 0.7) ? 2 : 0xFE));
+	    c.code.push_back((0x11 << 11) | (5 << 8) | 1);
+	    c.code.push_back((0x10 << 11) | (4 << 8) | (below(128) * 2 + (chance() < 0.05)));
+	    c.code.push_back((0x10 << 11) | (3 << 8) | (below(128) * 2 + (chance() < 0.05)));
+	    if (chance() < 0.2) {
+		c.code.push_back((0x12 << 11) | (4 << 8) | ((chance() < 0.5) ? 0xFF : below(256)));
+	    }
+	    c.code.push_back((0x11 << 11) | (2 << 8) | below(256));
+	    c.code.push_back((0x10 << 11) | (7 << 8) | (1 + below(255)));
+	    start = c.code.size();
+	    op = (chance() < 0.5);
+	    if (op) {
+		c.code.push_back((0x08 << 11) | (2 << 8) | (3 << 5) | (below(2) << 2));
+	    }
+	    c.code.push_back((0x09 << 11) | (below(2) << 8) | (4 << 5) | (2 << 2));
+	    c.code.push_back((0x00 << 11) | (4 << 8) | (4 << 5) | (6 << 2));
+	    if (op) {
+		c.code.push_back((0x00 << 11) | (3 << 8) | (3 << 5) | (6 << 2));
+	    }
+	    c.code.push_back((0x01 << 11) | (7 << 8) | (7 << 5) | (5 << 2));
+	    c.code.push_back((0x16 << 11) | (7 << 8) | start);
+	}
+	else if (kind < 0.86) {
+	    // Counted loop: R6 = 1, R7 counts down, body avoids both
+	    start = c.code.size() + 3;
+	    c.code.push_back((0x11 << 11) | (6 << 8) | 1);
+	    c.code.push_back((0x10 << 11) | (7 << 8) | (1 + below(40)));
+	    c.code.push_back((0x11 << 11) | (reg() % 6 << 8) | below(256));
+	    for (k = 1 + below(4); k > 0; k--) {
+		if (chance() < 0.25) {
+		    op = 0x08 + below(2);
+		}
+		else {
+		    op = alu_ops[below(4)];
+		}
+		c.code.push_back((op << 11) | (reg() % 6 << 8) | (reg() % 6 << 5) | (reg() % 6 << 2));
+	    }
+	    c.code.push_back((0x01 << 11) | (7 << 8) | (7 << 5) | (6 << 2));
+	    c.code.push_back((0x16 << 11) | (7 << 8) | start);
+	}
+	else if (kind < 0.89) {
+	    c.code.push_back((0x0E << 11) | (reg() << 5));
+	}
+	else if (kind < 0.91) {
+	    c.code.push_back((0x18 << 11) | below(n));
+	}
+	else if (kind < 0.93) {
+	    if (c.perf && (chance() < 0.75)) {
+		c.code.push_back((perf_ops[below(4)] << 11) | (reg() << 8) | below(256));
+	    }
+	    else {
+		c.code.push_back(invalid_ops[below(3)] << 11);
+	    }
+	}
+	else if (kind < 0.96) {
+	    c.code.push_back((0x13 << 11) | (reg() << 8) | (reg() << 5));
+	}
+	else if (kind < 0.98) {
+	    c.code.push_back((0x0C << 11) | (reg() << 5));
+	}
+	else {
+	    c.code.push_back(0x0D << 11);
+	}
+    }
+    c.code.push_back(0x0D << 11);
+
+    for (k = below(17); k > 0; k--) {
+	c.data_addr.push_back(below(128) * 2);
+	c.data.push_back(rng() & 0xFFFF);
+    }
+
+    // Half the runs stop at an arbitrary instruction
+    c.limit = (chance() < 0.5) ? FUZZ_MAX_INSTRUCTIONS : 1 + below(FUZZ_MAX_INSTRUCTIONS);
+    c.banks = (chance() < 0.2) ? 2 + below(3) : 1;
+
+    return;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Simulator, case, engine (index into engine_names)
+// Outputs: What the run left behind
+// ////////////////////////////////////////////////////////
+static void fuzz_run(xsim * x, const struct fuzz_case & c, int engine, struct fuzz_result & r) {
+    struct xsim_config config;
+    unsigned char bytes[2];		// Big-endian data word
+    vector<unsigned char> code;
+    unsigned int i;
+
+    xsim_default_config(&config);
+    config.engine = engine ? XSIM_ENGINE_FAST : XSIM_ENGINE_REFERENCE;
+    config.memoize_kb = (engine == 2) ? 16 : 0;
+    config.max_instructions = c.limit;
+    config.mem_banks = c.banks;
+    config.perf_isa = c.perf;
+    xsim_configure(x, &config);
+
+    for (i = 0; i < c.code.size(); i++) {
+	code.push_back(c.code[i] >> 8);
+	code.push_back(c.code[i] & 0x00FF);
+    }
+    xsim_load_binary(x, code.data(), code.size());
+
+    for (i = 0; i < c.data.size(); i++) {
+	bytes[0] = c.data[i] >> 8;
+	bytes[1] = c.data[i] & 0x00FF;
+	xsim_write_data(x, 0, c.data_addr[i], bytes, 2);
+    }
+
+    r.status = xsim_run(x);
+    xsim_registers(x, &r.regs);
+    xsim_stats(x, &r.stats);
+    r.digest = xsim_data_digest(x);
+    r.output = xsim_output(x);
+
+    return;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Results of the reference and another engine
+// Outputs: What differs, or 0 if nothing does
+// ////////////////////////////////////////////////////////
+static const char * fuzz_compare(const struct fuzz_result & a, const struct fuzz_result & b) {
+
+    if (a.status != b.status) {
+	return "status";
+    }
+    if (a.regs.pc != b.regs.pc) {
+	return "pc";
+    }
+    if (memcmp(a.regs.r, b.regs.r, sizeof(a.regs.r))) {
+	return "registers";
+    }
+    if (memcmp(a.stats.count, b.stats.count, sizeof(a.stats.count))) {
+	return "clock_cycles";
+    }
+    if ((a.stats.instructions != b.stats.instructions) || (a.stats.cycles != b.stats.cycles)) {
+	return "totals";
+    }
+    if (a.digest != b.digest) {
+	return "data memory";
+    }
+    if (a.output != b.output) {
+	return "output";
+    }
+
+    return 0;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Simulator, case, engine
+// Outputs: What differs from the reference engine, or 0
+// ////////////////////////////////////////////////////////
+static const char * fuzz_check(xsim * x, const struct fuzz_case & c, int engine) {
+    struct fuzz_result reference;
+    struct fuzz_result other;
+
+    fuzz_run(x, c, 0, reference);
+    fuzz_run(x, c, engine, other);
+
+    return fuzz_compare(reference, other);
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Simulator, failing case, engine
+// Description: Makes the case smaller as long as it still fails:
+//              HALT as early as possible, drop instructions and data
+//              words one at a time, lower the instruction limit
+// ////////////////////////////////////////////////////////
+static void fuzz_shrink(xsim * x, struct fuzz_case & c, int engine) {
+    struct fuzz_case trial;
+    unsigned int i;
+    int progress = 1;
+
+    while (progress) {
+	progress = 0;
+
+	for (i = 0; i + 1 < c.code.size(); i++) {
+	    trial = c;
+	    trial.code.resize(i + 1);
+	    trial.code[i] = 0x0D << 11;
+	    if (fuzz_check(x, trial, engine)) {
+		c = trial;
+		progress = 1;
+		break;
+	    }
+	}
+
+	for (i = 0; i < c.code.size(); i++) {
+	    trial = c;
+	    trial.code.erase(trial.code.begin() + i);
+	    if (!trial.code.empty() && fuzz_check(x, trial, engine)) {
+		c = trial;
+		progress = 1;
+		i--;
+	    }
+	}
+
+	for (i = 0; i < c.data.size(); i++) {
+	    trial = c;
+	    trial.data.erase(trial.data.begin() + i);
+	    trial.data_addr.erase(trial.data_addr.begin() + i);
+	    if (fuzz_check(x, trial, engine)) {
+		c = trial;
+		progress = 1;
+		i--;
+	    }
+	}
+
+	while (c.limit > 1) {
+	    trial = c;
+	    trial.limit = c.limit / 2;
+	    if (!fuzz_check(x, trial, engine)) {
+		break;
+	    }
+	    c = trial;
+	    progress = 1;
+	}
+
+	if (c.banks > 1) {
+	    trial = c;
+	    trial.banks = 1;
+	    if (fuzz_check(x, trial, engine)) {
+		c = trial;
+		progress = 1;
+	    }
+	}
+    }
+
+    return;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Simulator, shrunk case, engine, seed it came from
+// Description: Prints the mismatch and writes fuzz-SEED.txt, and
+//              fuzz-SEED.bin for the initial data memory, to run it
+//              with bin/xsim
+// ////////////////////////////////////////////////////////
+static void fuzz_report(xsim * x, const struct fuzz_case & c, int engine, unsigned long long seed) {
+    struct fuzz_result a, b;
+    char name[64];
+    vector<unsigned char> image;
+    FILE * out;
+    unsigned int i;
+    int k;
+
+    fuzz_run(x, c, 0, a);
+    fuzz_run(x, c, engine, b);
+
+    cout << "Mismatch in " << fuzz_compare(a, b) << " between reference and " << engine_names[engine]
+	 << " engines, seed " << seed << endl;
+    for (k = 0; k < 2; k++) {
+	const struct fuzz_result & r = k ? b : a;
+	printf("  %-9s status %d  PC 0x%04x  Instructions %llu  Cycles %llu  Registers", engine_names[k ? engine : 0], r.status, r.regs.pc,
+	       r.stats.instructions, r.stats.cycles);
+	for (i = 0; i < 8; i++) {
+	    printf(" %d", r.regs.r[i]);
+	}
+	printf("  Memory %016llx\n", r.digest);
+	printf("           ");
+	for (i = 0; i < XSIM_STATS; i++) {
+	    if (r.stats.count[i]) {
+		printf(" %s=%llu", xsim_stat_name(i), r.stats.count[i]);
+	    }
+	}
+	printf("\n");
+    }
+
+    snprintf(name, sizeof(name), "fuzz-%llu.txt", seed);
+    out = fopen(name, "w");
+    if (out) {
+	fprintf(out, "# xsim-fuzz seed %llu, reference and %s engines differ\n", seed, engine_names[engine]);
+	for (i = 0; i < c.code.size(); i++) {
+	    fprintf(out, "%04X\n", c.code[i]);
+	}
+	fclose(out);
+    }
+    cout << "  Program written to " << name << endl;
+
+    if (!c.data.empty()) {
+	for (i = 0; i < c.data.size(); i++) {
+	    if (image.size() < (size_t)c.data_addr[i] + 2) {
+		image.resize(c.data_addr[i] + 2);
+	    }
+	    image[c.data_addr[i]] = c.data[i] >> 8;
+	    image[c.data_addr[i] + 1] = c.data[i] & 0x00FF;
+	}
+	snprintf(name, sizeof(name), "fuzz-%llu.bin", seed);
+	out = fopen(name, "wb");
+	if (out) {
+	    fwrite(image.data(), 1, image.size(), out);
+	    fclose(out);
+	}
+	cout << "  Initial data memory written to " << name << " (--data-in)" << endl;
+    }
+    cout << "  Run with --max-instructions=" << c.limit;
+    if (c.banks > 1) {
+	cout << " --mem-banks=" << c.banks;
+    }
+    if (c.perf) {
+	cout << " --perf-isa";
+    }
+    cout << " and latencies of 1" << endl;
+
+    return;
+}
+
+// ////////////////////////////////////////////////////////
+// Inputs: Seeds to stop at, time to stop at
+// Description: Checks programs until either is reached or another
+//              worker found a mismatch
+// ////////////////////////////////////////////////////////
+static void fuzz_worker(unsigned long long last_seed, double deadline) {
+    struct fuzz_case c;
+    const char * diff;
+    unsigned long long seed;
+    xsim * x;
+    int engine;
+    int k;
+
+    x = xsim_create();
+
+    while (!stop && (now() < deadline)) {
+	for (k = 0; k < FUZZ_BATCH; k++) {
+	    seed = next_seed++;
+	    if (seed >= last_seed) {
+		xsim_destroy(x);
+		return;
+	    }
+	    fuzz_generate(seed, c);
+	    for (engine = 1; engine <= 2; engine++) {
+		diff = fuzz_check(x, c, engine);
+		if (diff) {
+		    if (stop.exchange(1)) {
+			break;
+		    }
+		    fuzz_shrink(x, c, engine);
+		    lock_guard<mutex> hold(report_lock);
+		    fuzz_report(x, c, engine, seed);
+		    break;
+		}
+	    }
+	    programs_run++;
+	    if (stop) {
+		break;
+	    }
+	}
+    }
+
+    xsim_destroy(x);
+
+    return;
+}
+
+static void print_usage(char * program) {
+    cout << "Usage: " << program << " [options]" << endl;
+    cout << "\t--seed=N\t\tFirst seed (default 1)" << endl;
+    cout << "\t--count=N\t\tPrograms to check, 0 for no limit (default 0)" << endl;
+    cout << "\t--seconds=S\t\tStop after S seconds (default 60)" << endl;
+    cout << "\t--jobs=N\t\tWorker threads (default one per core)" << endl;
+}
+
+int main(int argc, char * argv[]) {
+    unsigned long long seed = 1;	// First seed
+    unsigned long long count = 0;	// Programs to check
+    double seconds = 60;		// Time limit
+    double start;
+    double elapsed;
+    vector<thread> workers;
+    int jobs = 0;
+    int option;
+    int k;
+
+    static struct option long_options[] = {
+	{"seed", required_argument, 0, 's'},
+	{"count", required_argument, 0, 'n'},
+	{"seconds", required_argument, 0, 't'},
+	{"jobs", required_argument, 0, 'j'},
+	{0, 0, 0, 0}
+    };
+
+    while ((option = getopt_long(argc, argv, "", long_options, 0)) != -1) {
+	switch (option) {
+	    case 's':
+		seed = strtoull(optarg, 0, 10);
+		break;
+	    case 'n':
+		count = strtoull(optarg, 0, 10);
+		break;
+	    case 't':
+		seconds = atof(optarg);
+		break;
+	    case 'j':
+		jobs = atoi(optarg);
+		break;
+	    default:
+		print_usage(argv[0]);
+		return -1;
+	}
+    }
+    if ((seconds <= 0) || (optind != argc)) {
+	print_usage(argv[0]);
+	return -1;
+    }
+    if (jobs <= 0) {
+	jobs = thread::hardware_concurrency() ? thread::hardware_concurrency() : 1;
+    }
+
+    next_seed = seed;
+    start = now();
+    for (k = 0; k < jobs; k++) {
+	workers.push_back(thread(fuzz_worker, count ? seed + count : ~0ULL, start + seconds));
+    }
+    for (k = 0; k < jobs; k++) {
+	workers[k].join();
+    }
+    elapsed = now() - start;
+
+    printf("%llu programs in %.1f s with %d threads, %.0f programs per minute, %s\n", (unsigned long long)programs_run,
+	   elapsed, jobs, programs_run * 60 / elapsed, stop ? "mismatch found" : "no mismatches");
+
+    return stop ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+// ////////////////////////////////////////////////////////
+// File: xsim-top.cpp
+// Description: Lists every simulation on the host that publishes live
+//              metrics (xsim --live) and refreshes the table until
+//              interrupted. Finished runs are listed with their final
+//              state until their segment expires, then removed.
+// Author: ZDHull
+// Date: 2026/10/19
+// ////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <string>
+#include <vector>
+#include "xlive.h"
+
+using namespace std;
+
+// Names of the clock_cycles entries, in Instruction_Name order
+static const char * inst_names[22] = {
+    "add", "sub", "and", "nor", "div", "mul", "mod", "exp", "lw", "sw", "liz",
+    "lis", "lui", "bp", "bn", "bx", "bz", "jr", "jal", "j", "halt", "put"
+};
+
+// Names of each Live_State
+static const char * state_names[5] = {
+    "unknown", "running", "halted", "error", "limit"
+};
+
+// ////////////////////////////////////////////////////////
+// Inputs: Segment file name in LIVE_SHM_DIR, copy destination
+// Outputs: 0 when a consistent copy was made
+// Description: Maps one segment and copies it under the sequence lock
+// ////////////////////////////////////////////////////////
+int read_segment(const char * name, struct live_metrics * copy) {
+    struct live_metrics * live;
+    unsigned int before, after;
+    string path;
+    int fd;
+    int tries;
+
+    path = string("/") + name;
+    fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+	return -1;
+    }
+
+    live = (struct live_metrics *)mmap(0, sizeof(struct live_metrics), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (live == MAP_FAILED) {
+	return -1;
+    }
+
+    // Retry while the writer is inside its update
+    for (tries = 0; tries < 1000; tries++) {
+	before = __atomic_load_n(&live->sequence, __ATOMIC_ACQUIRE);
+	if (before & 1) {
+	    continue;
+	}
+	memcpy(copy, live, sizeof(struct live_metrics));
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	after = __atomic_load_n(&live->sequence, __ATOMIC_RELAXED);
+	if (before == after) {
+	    break;
+	}
+    }
+
+    munmap(live, sizeof(struct live_metrics));
+
+    if ((tries == 1000) || (copy->magic != LIVE_MAGIC) || (copy->version != LIVE_VERSION)) {
+	return -1;
+    }
+
+    return 0;
+}
+
+// ////////////////////////////////////////////////////////
+// Description: Prints one table of all live simulations
+// ////////////////////////////////////////////////////////
+void print_table() {
+    DIR * dir;
+    struct dirent * entry;
+    struct live_metrics copy;
+    struct timespec ts;
+    unsigned long long now;
+    unsigned long long end;		// Time the run stopped or now
+    double elapsed;
+    int top;
+    int i;
+    int count;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    now = (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+    printf("%-8s %-24s %-8s %14s %6s %9s %9s %9s  %s\n", "PID", "PROGRAM", "STATE", "INSTRUCTIONS", "PC", "MIPS", "AVG MIPS", "ELAPSED", "TOP OPCODE");
+
+    dir = opendir(LIVE_SHM_DIR);
+    if (!dir) {
+	return;
+    }
+
+    count = 0;
+    while ((entry = readdir(dir)) != 0) {
+	if (strncmp(entry->d_name, LIVE_SHM_PREFIX + 1, strlen(LIVE_SHM_PREFIX) - 1) != 0) {
+	    continue;
+	}
+	if (read_segment(entry->d_name, &copy) != 0) {
+	    continue;
+	}
+	// Remove finished runs past their linger time and killed ones
+	if (live_expired(&copy, now)) {
+	    shm_unlink((string("/") + entry->d_name).c_str());
+	    continue;
+	}
+
+	top = 0;
+	for (i = 1; i < 22; i++) {
+	    if (copy.clock_cycles[i] > copy.clock_cycles[top]) {
+		top = i;
+	    }
+	}
+
+	// Finished runs stopped their clock at the last update
+	end = (copy.state == LIVE_RUNNING) ? now : copy.update_ns;
+	elapsed = (end > copy.start_ns) ? ((end - copy.start_ns) / 1e9) : 0.0;
+
+	printf("%-8d %-24.24s %-8s %14llu 0x%04x %9.2f %9.2f %8.1fs  %s (%llu)\n", copy.pid, copy.program,
+		state_names[(copy.state <= LIVE_LIMIT) ? copy.state : 0],
+		copy.instructions, copy.program_counter, copy.mips, copy.average_mips, elapsed,
+		inst_names[top], copy.clock_cycles[top]);
+	count++;
+    }
+
+    closedir(dir);
+
+    if (count == 0) {
+	printf("(no simulations)\n");
+    }
+
+    return;
+}
+
+int main (int argc, char *argv[]) {
+    int once;		// Print a single table and exit
+    int delay;		// Seconds between refreshes
+    int option;
+
+    once = 0;
+    delay = 1;
+
+    while ((option = getopt(argc, argv, "1d:")) != -1) {
+	switch (option) {
+	    case '1':
+		once = 1;
+		break;
+	    case 'd':
+		delay = atoi(optarg);
+		if (delay <= 0) {
+		    delay = 1;
+		}
+		break;
+	    default:
+		printf("Invalid Usage...\n\t%s [-1] [-d seconds]\n", argv[0]);
+		return -1;
+	}
+    }
+
+    if (once) {
+	print_table();
+	return 0;
+    }
+
+    while (1) {
+	// Clear the terminal and redraw
+	printf("\033[H\033[2J");
+	print_table();
+	fflush(stdout);
+	sleep(delay);
+    }
+
+    return 0;
+}